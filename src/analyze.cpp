@@ -0,0 +1,227 @@
+#include "analyze.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess/all.h"
+#include "utils/strings.h"
+#include "utils/timer.h"
+#include "evalcache.h"
+#include "search.h"
+#include "tt.h"
+
+namespace sonic {
+
+namespace {
+
+// At most this many lines are read ahead of the first line not yet written, which bounds memory
+// use whatever the length of the file and however long single searches take.
+constexpr std::size_t WINDOW_SIZE = 4096;
+
+// Progress is printed every this many positions.
+constexpr std::uint64_t PROGRESS_INTERVAL = 4096;
+
+// Line of the input, from when it is read until its result is written.
+struct Slot {
+    std::string line;
+    std::string result;
+    bool        ready = false;
+};
+
+struct AnalyzeLimits {
+    int           depth = MAX_DEPTH;
+    std::uint64_t nodes = std::numeric_limits<std::uint64_t>::max() / 2;
+};
+
+// Returns the first four fields of an EPD or FEN line, and the full FEN to set up the position.
+bool parse_epd(const std::string& line, std::string& epd, std::string& fen) {
+    std::vector<std::string> tokens = split_string(line, ' ');
+    if (tokens.size() < 4 || std::count(tokens[0].begin(), tokens[0].end(), '/') != 7) {
+        return false;
+    }
+    auto is_number = [](const std::string& s) {
+        return !s.empty() && std::all_of(s.begin(), s.end(), ::isdigit);
+    };
+    epd = tokens[0] + " " + tokens[1] + " " + tokens[2] + " " + tokens[3];
+    fen = epd;
+    if (tokens.size() >= 6 && is_number(tokens[4]) && is_number(tokens[5])) {
+        fen += " " + tokens[4] + " " + tokens[5];
+    } else {
+        fen += " 0 1";
+    }
+    return true;
+}
+
+// Searches the position of `line` from scratch and returns it as EPD with the search depth,
+// nodes, score, best move and PV as opcodes, or an empty string if it is not a position.
+std::string analyze_line(const std::string&   line,
+                         const AnalyzeLimits& limits,
+                         TranspositionTable&  tt,
+                         std::uint64_t&       nodes) {
+    std::string epd, fen;
+    if (!parse_epd(line, epd, fen)) {
+        return "";
+    }
+    Position   pos(fen);
+    SearchInfo search_info;
+    search_info.max_depth  = limits.depth;
+    search_info.max_nodes  = limits.nodes;
+    search_info.silent     = true;
+    search_info.use_book   = false;
+    search_info.tt         = &tt;
+    search_info.start_time = current_time();
+    tt.clear();
+    eval_cache.clear();
+    search(pos, search_info);
+    nodes += search_info.nodes;
+
+    std::ostringstream out;
+    out << epd << " acd " << search_info.completed_depth << "; acn " << search_info.nodes
+        << "; ce " << search_info.best_score << "; bm " << search_info.best_move.to_string()
+        << "; pv " << search_info.best_pv << ";";
+    return out.str();
+}
+
+} // namespace
+
+void analyze(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 4) {
+        std::cout
+            << "Usage: analyze <file.epd> depth|nodes N [threads T] [hash MB] [out <file>]"
+            << std::endl;
+        return;
+    }
+    std::string   epd_file = tokens[1];
+    std::string   out_file = epd_file + ".out";
+    AnalyzeLimits limits;
+    int           threads = std::max(1, int(std::thread::hardware_concurrency()));
+    int           hash_mb = 2;
+    for (std::size_t i = 2; i + 1 < tokens.size(); i += 2) {
+        if (tokens[i] == "depth") {
+            limits.depth = std::clamp(std::stoi(tokens[i + 1]), 1, MAX_DEPTH);
+        } else if (tokens[i] == "nodes") {
+            limits.nodes = std::max<std::uint64_t>(1, std::stoull(tokens[i + 1]));
+        } else if (tokens[i] == "threads") {
+            threads = std::max(1, std::stoi(tokens[i + 1]));
+        } else if (tokens[i] == "hash") {
+            hash_mb = std::max(1, std::stoi(tokens[i + 1]));
+        } else if (tokens[i] == "out") {
+            out_file = tokens[i + 1];
+        }
+    }
+    std::ifstream in(epd_file);
+    if (!in) {
+        std::cout << "info string cannot read " << epd_file << std::endl;
+        return;
+    }
+    std::ofstream out(out_file);
+    if (!out) {
+        std::cout << "info string cannot write " << out_file << std::endl;
+        return;
+    }
+
+    // Line i is kept in slots[i % WINDOW_SIZE]. The workers take the indices of the lines to
+    // search from `queue`, and this thread writes the results in input order as they are ready.
+    std::vector<Slot>          slots(WINDOW_SIZE);
+    std::deque<std::size_t>    queue;
+    std::mutex                 mutex;
+    std::condition_variable    work_cv, result_cv;
+    bool                       input_done = false;
+    std::vector<std::uint64_t> thread_nodes(threads, 0);
+
+    // The workers live for the whole file, each with its own transposition table and an eval
+    // cache of `hash` MB. Both are cleared before each position, so the results do not depend on
+    // the number of threads.
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            TranspositionTable tt(hash_mb);
+            eval_cache.resize(hash_mb);
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                work_cv.wait(lock, [&] { return !queue.empty() || input_done; });
+                if (queue.empty()) {
+                    return;
+                }
+                Slot& slot = slots[queue.front() % WINDOW_SIZE];
+                queue.pop_front();
+                lock.unlock();
+                slot.result = analyze_line(slot.line, limits, tt, thread_nodes[t]);
+                lock.lock();
+                slot.ready = true;
+                result_cv.notify_one();
+            }
+        });
+    }
+
+    std::uint64_t                positions = 0, skipped = 0;
+    std::size_t                  read      = 0, written = 0;
+    TimePoint                    start     = current_time();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        for (Slot* slot = &slots[written % WINDOW_SIZE]; written < read && slot->ready;
+             slot = &slots[++written % WINDOW_SIZE]) {
+            if (slot->result.empty()) {
+                skipped += !slot->line.empty();
+            } else {
+                out << slot->result << "\n";
+                if (++positions % PROGRESS_INTERVAL == 0) {
+                    std::uint64_t ms = time_elapsed(start);
+                    std::cout << "info string " << positions << " positions, "
+                              << positions * 1000 / (ms + 1) << " positions/s" << std::endl;
+                }
+            }
+            slot->ready = false;
+        }
+        if (!input_done && read - written < WINDOW_SIZE) {
+            // The slot is free, so no worker touches it while the line is read.
+            lock.unlock();
+            Slot& slot = slots[read % WINDOW_SIZE];
+            if (std::getline(in, slot.line)) {
+                if (!slot.line.empty() && slot.line.back() == '\r') {
+                    slot.line.pop_back();
+                }
+                lock.lock();
+                queue.push_back(read++);
+                work_cv.notify_one();
+            } else {
+                lock.lock();
+                input_done = true;
+                work_cv.notify_all();
+            }
+            continue;
+        }
+        if (input_done && written == read) {
+            break;
+        }
+        result_cv.wait(lock);
+    }
+    lock.unlock();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    out.flush();
+
+    std::uint64_t nodes = 0;
+    for (std::uint64_t n : thread_nodes) {
+        nodes += n;
+    }
+    std::uint64_t ms = time_elapsed(start);
+    std::cout << "Positions       : " << positions << " (" << skipped << " skipped)" << std::endl;
+    std::cout << "Total time (ms) : " << ms << std::endl;
+    std::cout << "Positions/second: " << positions * 1000 / (ms + 1) << std::endl;
+    std::cout << "Nodes/second    : " << nodes * 1000 / (ms + 1) << std::endl;
+    std::cout << "Results written to " << out_file << std::endl;
+}
+
+} // namespace sonic
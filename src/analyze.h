@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sonic {
+
+// Searches every position of an EPD file to a fixed depth or node count, running independent
+// single-threaded searches in parallel, and writes each position with its result in input order.
+// Usage: analyze <file.epd> depth|nodes N [threads T] [hash MB] [out <file>]
+void analyze(const std::vector<std::string>& tokens);
+
+} // namespace sonic
@@ -1,6 +1,9 @@
 #include "benchmark.h"
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -8,8 +11,11 @@
 #include "../utils/strings.h"
 #include "../utils/timer.h"
 #include "../book.h"
+#include "../evalcache.h"
+#include "../evaluate.h"
 #include "../uci.h"
 #include "../search.h"
+#include "perf_counters.h"
 
 namespace {
 
@@ -71,29 +77,199 @@ std::vector<std::string> bench_positions = {
 
 namespace sonic {
 
-void run_bench() {
-    const std::vector<std::string> go_params  = {"go", "depth", "6"};
+std::vector<Position> load_bench_positions() {
+    std::vector<Position> positions;
+    SearchInfo            search_info;
+    for (const std::string& fen : bench_positions) {
+        Position pos;
+        parse_position(pos, search_info, split_string("position fen " + fen, ' '));
+        positions.push_back(pos);
+    }
+    return positions;
+}
+
+// Average cost of a static evaluation on the bench positions, in nanoseconds. An empty window
+// makes every evaluation take the lazy exit.
+double evaluation_cost(bool lazy_exit) {
+    constexpr int         repeats   = 2000;
+    std::vector<Position> positions = load_bench_positions();
+    Value                 checksum  = 0;
+    TimePoint             start     = current_time();
+    for (int i = 0; i < repeats; i++) {
+        for (const Position& pos : positions) {
+            AttackInfo ai(pos);
+            bool       lazy = false;
+            checksum += (lazy_exit ? evaluate(pos, ai, 0, 0, lazy) : evaluate(pos, ai));
+        }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(current_time() - start).count();
+    // Keep the evaluations from being optimized away.
+    if (checksum == VALUE_NONE) {
+        std::cout << checksum << std::endl;
+    }
+    return double(ns) / (repeats * positions.size());
+}
+
+namespace {
+
+struct BenchResult {
+    std::string   fen;
+    int           depth;
+    Move          best_move;
+    std::uint64_t nodes;
+    std::uint64_t ms;
+};
+
+// Reads the positions of a bench file, one FEN (optionally followed by "moves ...") per line.
+std::vector<std::string> read_bench_positions(const std::string& filename) {
+    std::vector<std::string> positions;
+    std::ifstream            in(filename);
+    if (!in) {
+        std::cout << "Cannot open " << filename << std::endl;
+        return positions;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            positions.push_back(line);
+        }
+    }
+    return positions;
+}
+
+void print_json(const std::vector<BenchResult>& results,
+                int                             depth,
+                int                             threads,
+                int                             hash_mb,
+                std::uint64_t                   node_count,
+                std::uint64_t                   ms,
+                const PerfCounters*             counters) {
+    std::cout << "{\n";
+    std::cout << "  \"depth\": " << depth << ",\n";
+    std::cout << "  \"threads\": " << threads << ",\n";
+    std::cout << "  \"hash\": " << hash_mb << ",\n";
+    std::cout << "  \"slider_attacks\": \"" << (use_pext ? "pext" : "magic") << "\",\n";
+    std::cout << "  \"move_undo\": \"" << (use_copy_make ? "copy-make" : "make/unmake")
+              << "\",\n";
+    std::cout << "  \"positions\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        std::cout << "    {\"fen\": \"" << r.fen << "\", \"depth\": " << r.depth
+                  << ", \"bestmove\": \"" << r.best_move.to_string() << "\", \"nodes\": "
+                  << r.nodes << ", \"time\": " << r.ms
+                  << ", \"nps\": " << (r.nodes * 1000) / (r.ms + 1) << "}"
+                  << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ],\n";
+    std::cout << "  \"nodes\": " << node_count << ",\n";
+    std::cout << "  \"time\": " << ms << ",\n";
+    if (counters) {
+        std::cout << "  \"counters\": " << counters->json() << ",\n";
+    }
+    std::cout << "  \"nps\": " << (node_count * 1000) / (ms + 1) << "\n";
+    std::cout << "}" << std::endl;
+}
+
+} // namespace
+
+void run_bench(std::vector<std::string> tokens) {
+    bool        json          = take_flag(tokens, "json");
+    bool        with_counters = take_flag(tokens, "counters");
+    int         depth         = (tokens.size() > 1 ? std::stoi(tokens[1]) : 6);
+    std::string file          = (tokens.size() > 4 ? tokens[4] : "default");
+    // The search reads its settings from the options, which are restored afterwards.
+    int old_threads = int(options["Threads"]);
+    int old_hash_mb = int(options["Hash"]);
+    options.set("Threads", tokens.size() > 2 ? tokens[2] : "1");
+    options.set("Hash", tokens.size() > 3 ? tokens[3] : "16");
+    int threads = int(options["Threads"]);
+    int hash_mb = int(options["Hash"]);
+
+    std::vector<std::string> positions =
+        (file == "default" ? bench_positions : read_bench_positions(file));
+    const std::vector<std::string> go_params  = {"go", "depth", std::to_string(depth)};
     std::uint64_t                  node_count = 0;
-    TimePoint                      start      = current_time();
+    std::uint64_t                  lazy_evals = 0;
+    std::uint64_t                  ms         = 0;
+    std::vector<BenchResult>       results;
     Position                       pos;
     SearchInfo                     search_info;
-    for (size_t i = 0; i < bench_positions.size(); i++) {
-        std::string              fen    = "position fen " + bench_positions[i];
+    TT.resize(hash_mb);
+    // The searches run on this thread, so they use its evaluation cache.
+    eval_cache.resize(int(options["EvalCache"]));
+    eval_cache.reset_stats();
+    clear_search_stats();
+    // Opened before the search threads start so that they are counted too.
+    std::unique_ptr<PerfCounters> counters(with_counters ? new PerfCounters() : nullptr);
+    for (size_t i = 0; i < positions.size(); i++) {
+        std::string              fen    = "position fen " + positions[i];
         std::vector<std::string> params = split_string(fen, ' ');
         parse_position(pos, search_info, params);
-        parse_go(pos, search_info, go_params);
+        // Clear the tables before the search clock starts.
         TT.clear();
-        std::cout << "Position [" << i + 1 << "/" << bench_positions.size() << "]"
-                  << " (" << pos.fen() << ")" << std::endl;
+        eval_cache.clear();
+        if (!json) {
+            std::cout << "Position [" << i + 1 << "/" << positions.size() << "]"
+                      << " (" << pos.fen() << ")" << std::endl;
+        }
+        parse_go(pos, search_info, go_params);
+        search_info.silent = json;
+        if (counters) {
+            counters->start();
+        }
         search(pos, search_info);
+        if (counters) {
+            counters->stop();
+        }
+        std::uint64_t position_ms = time_elapsed(search_info.start_time);
+        results.push_back({pos.fen(), search_info.completed_depth, search_info.best_move,
+                           search_info.nodes, position_ms});
         node_count += search_info.nodes;
-        std::cout << "\n";
+        lazy_evals += search_info.lazy_evals;
+        ms += position_ms;
+        if (!json) {
+            std::cout << "Depth " << search_info.completed_depth << ", best move "
+                      << search_info.best_move.to_string() << ", nodes " << search_info.nodes
+                      << ", time " << position_ms << " ms, nps "
+                      << (search_info.nodes * 1000) / (position_ms + 1) << "\n"
+                      << std::endl;
+        }
     }
-    std::uint64_t ms = time_elapsed(start);
+    options.set("Threads", std::to_string(old_threads));
+    options.set("Hash", std::to_string(old_hash_mb));
+    TT.resize(old_hash_mb);
+
+    if (json) {
+        print_json(results, depth, threads, hash_mb, node_count, ms, counters.get());
+        return;
+    }
+    std::uint64_t eval_hits = eval_cache.hits;
+    double        full_cost = evaluation_cost(false);
+    double        lazy_cost = evaluation_cost(true);
+    double        saved_ms  = eval_hits * full_cost / 1e6;
+    double        lazy_ms   = lazy_evals * (full_cost - lazy_cost) / 1e6;
     std::cout << std::string(20, '=') << std::endl;
     std::cout << "Total time (ms) : " << ms << std::endl;
     std::cout << "Nodes searched  : " << node_count << std::endl;
     std::cout << "Nodes/second    : " << (node_count * 1000) / (ms + 1) << std::endl;
+    std::cout << "Slider attacks  : " << (use_pext ? "pext" : "magic") << std::endl;
+    std::cout << "Move undo       : " << (use_copy_make ? "copy-make" : "make/unmake") << std::endl;
+    std::cout << "Eval cache hits : " << eval_hits << "/" << eval_cache.probes << " ("
+              << eval_hits * 100 / (eval_cache.probes + 1) << "%)" << std::endl;
+    std::cout << "Eval saved (ms) : " << std::uint64_t(saved_ms) << std::endl;
+    std::cout << "Eval cost (ns)  : " << std::uint64_t(full_cost) << " full, "
+              << std::uint64_t(lazy_cost) << " lazy" << std::endl;
+    std::cout << "Lazy evals      : " << lazy_evals << " (" << std::uint64_t(lazy_ms)
+              << " ms saved)" << std::endl;
+    if (counters) {
+        std::cout << counters->report(node_count, "node") << std::flush;
+    }
+    if constexpr (use_search_stats) {
+        std::cout << total_search_stats().to_string() << std::flush;
+    }
 }
 
 } // namespace sonic
\ No newline at end of file
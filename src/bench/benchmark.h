@@ -1,7 +1,19 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include "../chess/position.h"
+
 namespace sonic {
 
-void run_bench();
+// Returns the positions searched by `bench`.
+std::vector<Position> load_bench_positions();
+
+// Searches the bench positions and prints the nodes, time, nps, depth and best move of each, and
+// the total node count as a signature of the search. With `counters` the hardware counters of the
+// searches are reported too.
+// Usage: bench [depth] [threads] [hash] [positions-file|default] [json] [counters]
+void run_bench(std::vector<std::string> tokens);
 
 } // namespace sonic
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "microbench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../chess/all.h"
+#include "../utils/strings.h"
+#include "../utils/timer.h"
+#include "../evaluate.h"
+#include "../movesort.h"
+#include "../tt.h"
+#include "benchmark.h"
+#include "perf_counters.h"
+
+namespace sonic {
+
+namespace {
+
+constexpr int WARMUP_RUNS = 2;
+constexpr int RUNS        = 15;
+
+// Each timed run repeats the work until it takes about this long, to rise above timer resolution.
+constexpr std::int64_t MIN_RUN_NS = 5000000;
+
+// Positions for the TT benchmarks, enough to spread over a large table.
+constexpr std::size_t TT_POSITIONS = 20000;
+
+// Results are accumulated here so that the timed work is not optimized away.
+volatile std::uint64_t sink = 0;
+
+// Hardware counters of the timed runs, if asked for.
+std::unique_ptr<PerfCounters> counters;
+
+template<typename Function>
+std::int64_t time_ns(Function run, int repeats) {
+    TimePoint start = current_time();
+    for (int i = 0; i < repeats; i++) {
+        run();
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(current_time() - start).count();
+}
+
+// Runs `run`, which performs `ops` operations, a few times untimed and then RUNS times timed, and
+// prints the median and 10th/90th percentiles of the time per operation. The ops column is the
+// number of operations per timed run. The counters, if any, are printed below as averages per
+// operation over all timed runs.
+template<typename Function>
+void measure(const std::string& name, const std::string& filter, std::uint64_t ops, Function run) {
+    if (name.compare(0, filter.size(), filter) != 0 || ops == 0) {
+        return;
+    }
+    std::int64_t        warmup_ns = time_ns(run, WARMUP_RUNS) / WARMUP_RUNS;
+    int                 repeats   = int(std::max<std::int64_t>(1, MIN_RUN_NS / (warmup_ns + 1)));
+    std::vector<double> samples;
+    if (counters) {
+        counters->reset();
+    }
+    for (int i = 0; i < RUNS; i++) {
+        if (counters) {
+            counters->start();
+        }
+        samples.push_back(double(time_ns(run, repeats)) / (ops * repeats));
+        if (counters) {
+            counters->stop();
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << samples[RUNS / 2] << std::setw(10)
+              << samples[RUNS / 10] << std::setw(10) << samples[RUNS * 9 / 10] << std::setw(10)
+              << ops * repeats << std::endl;
+    if (counters) {
+        std::cout << "    " << counters->summary(ops * repeats * RUNS) << std::endl;
+    }
+}
+
+// Returns the positions one ply after each of `positions`, up to `limit` of them.
+std::vector<Position> children(const std::vector<Position>& positions, std::size_t limit) {
+    std::vector<Position> result;
+    for (Position pos : positions) {
+        MoveList movelist;
+        generate_moves<GenType::LEGAL>(pos, movelist);
+        for (Move m : movelist) {
+            if (result.size() == limit) {
+                return result;
+            }
+            UndoInfo info;
+            pos.make_move(m, info);
+            result.push_back(pos);
+            pos.unmake_move(info);
+        }
+    }
+    return result;
+}
+
+template<GenType Type>
+void measure_movegen(const std::string&           name,
+                     const std::string&           filter,
+                     const std::vector<Position>& positions) {
+    measure(name, filter, positions.size(), [&]() {
+        for (const Position& pos : positions) {
+            MoveList movelist;
+            generate_moves<Type>(pos, movelist);
+            sink = sink + movelist.size();
+        }
+    });
+}
+
+void measure_tt(const std::string& filter, const std::vector<Position>& positions, int mb_size) {
+    TranspositionTable tt(mb_size);
+    std::string        size = std::to_string(mb_size) + "MB";
+    measure("tt store " + size, filter, positions.size(), [&]() {
+        for (const Position& pos : positions) {
+            tt.store(pos, 1, Value(0), MOVE_NONE, TTFlag::TT_EXACT);
+        }
+    });
+    measure("tt probe " + size, filter, positions.size(), [&]() {
+        for (const Position& pos : positions) {
+            Move move = MOVE_NONE;
+            sink      = sink + tt.probe(pos, 0, 1, -VALUE_INF, VALUE_INF, move);
+        }
+    });
+}
+
+} // namespace
+
+void run_microbench(std::vector<std::string> tokens) {
+    counters.reset(take_flag(tokens, "counters") ? new PerfCounters() : nullptr);
+    if (counters && !counters->available()) {
+        std::cout << counters->report(0, "op") << std::flush;
+        counters.reset();
+    }
+    std::string           filter    = (tokens.size() > 1 ? tokens[1] : "");
+    std::vector<Position> roots     = load_bench_positions();
+    std::vector<Position> positions = children(roots, SIZE_MAX);
+    std::vector<Position> in_check, not_in_check;
+    for (const Position& pos : children(positions, SIZE_MAX)) {
+        (pos.in_check() ? in_check : not_in_check).push_back(pos);
+    }
+    not_in_check.resize(std::min(not_in_check.size(), positions.size()));
+
+    // Legal moves of each position, generated up front so that make+unmake times nothing else.
+    std::vector<MoveList> movelists(positions.size());
+    std::uint64_t         moves = 0;
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        generate_moves<GenType::LEGAL>(positions[i], movelists[i]);
+        moves += movelists[i].size();
+    }
+
+    std::cout << positions.size() << " positions, " << in_check.size() << " in check, "
+              << RUNS << " runs after " << WARMUP_RUNS << " warmup runs" << std::endl;
+    std::cout << std::left << std::setw(28) << "Benchmark (ns/op)" << std::right << std::setw(10)
+              << "median" << std::setw(10) << "p10" << std::setw(10) << "p90" << std::setw(10)
+              << "ops" << std::endl;
+
+    measure_movegen<GenType::LEGAL>("movegen legal", filter, positions);
+    measure_movegen<GenType::CAPTURE>("movegen capture", filter, not_in_check);
+    measure_movegen<GenType::NON_CAPTURE>("movegen non-capture", filter, not_in_check);
+    measure_movegen<GenType::QUIET_CHECKS>("movegen quiet checks", filter, not_in_check);
+    measure_movegen<GenType::EVASIONS>("movegen evasions", filter, in_check);
+
+    // Make/unmake leaves the positions unchanged, so the copies are taken once.
+    std::vector<Position> scratch = positions;
+    measure("make+unmake", filter, moves, [&]() {
+        for (std::size_t i = 0; i < scratch.size(); i++) {
+            Position& pos = scratch[i];
+            for (Move m : movelists[i]) {
+                UndoInfo info;
+                pos.make_move(m, info);
+                sink = sink + pos.hashkey();
+                pos.unmake_move(info);
+            }
+        }
+    });
+
+    measure("evaluate", filter, positions.size(), [&]() {
+        for (const Position& pos : positions) {
+            AttackInfo ai(pos);
+            sink = sink + evaluate(pos, ai);
+        }
+    });
+
+    std::vector<Position> tt_positions = children(positions, TT_POSITIONS);
+    for (int mb_size : {1, 16, 256}) {
+        measure_tt(filter, tt_positions, mb_size);
+    }
+
+    measure("rook attacks", filter, positions.size() * Square::SQ_NB, [&]() {
+        for (const Position& pos : positions) {
+            Bitboard occupied = pos.pieces();
+            for (int sq = 0; sq < Square::SQ_NB; sq++) {
+                sink = sink + rook_attacks(Square(std::uint8_t(sq)), occupied).to_int();
+            }
+        }
+    });
+    measure("bishop attacks", filter, positions.size() * Square::SQ_NB, [&]() {
+        for (const Position& pos : positions) {
+            Bitboard occupied = pos.pieces();
+            for (int sq = 0; sq < Square::SQ_NB; sq++) {
+                sink = sink + bishop_attacks(Square(std::uint8_t(sq)), occupied).to_int();
+            }
+        }
+    });
+    measure("attacks_by", filter, positions.size() * Square::SQ_NB, [&]() {
+        for (const Position& pos : positions) {
+            Color them = other_color(pos.side_to_move());
+            for (int sq = 0; sq < Square::SQ_NB; sq++) {
+                sink = sink + pos.attacks_by(Square(std::uint8_t(sq)), them);
+            }
+        }
+    });
+
+    // Sorting works on a copy of the move list, which is part of the measured time.
+    measure("sort_moves", filter, positions.size(), [&]() {
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            MoveList movelist = movelists[i];
+            sort_moves(positions[i], movelist, MOVE_NONE);
+            sink = sink + (movelist.size() > 0 ? movelist[0].to_int() : 0);
+        }
+    });
+}
+
+} // namespace sonic
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sonic {
+
+// Times the hot paths of the engine (move generation, make/unmake, evaluation, TT, attack lookups
+// and move sorting) on positions around the bench positions, and prints the median and
+// percentiles of the time per operation over repeated runs. Only the benchmarks whose names
+// start with `filter` are run. With `counters` the hardware counters per operation are printed too.
+// Usage: microbench [filter] [counters]
+void run_microbench(std::vector<std::string> tokens);
+
+} // namespace sonic
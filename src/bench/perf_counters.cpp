@@ -0,0 +1,205 @@
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <cstring>
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace sonic {
+
+namespace {
+
+struct EventInfo {
+    const char* label; // padded to the width of the bench statistics
+    const char* short_name;
+    const char* json_name;
+};
+
+constexpr EventInfo Events[PerfCounters::EVENT_NB] = {
+    {"Cycles          : ", "cyc", "cycles"},
+    {"Instructions    : ", "ins", "instructions"},
+    {"L1D misses      : ", "l1d", "l1d_misses"},
+    {"LLC misses      : ", "llc", "llc_misses"},
+    {"Branch misses   : ", "brm", "branch_misses"},
+};
+
+#if defined(__linux__)
+int open_counter(PerfCounters::Event event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+    case PerfCounters::CYCLES :
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PerfCounters::INSTRUCTIONS :
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PerfCounters::L1D_MISSES :
+        attr.type   = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PerfCounters::LLC_MISSES :
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    default :
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+    attr.disabled       = 1;
+    attr.inherit        = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < EVENT_NB; i++) {
+        fds[i]    = -1;
+        counts[i] = 0;
+        valid[i]  = false;
+#if defined(__linux__)
+        fds[i] = open_counter(Event(i));
+        if (fds[i] < 0 && error.empty()) {
+            error = std::strerror(errno);
+        }
+#endif
+    }
+#if !defined(__linux__)
+    error = "perf_event_open needs Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+#if defined(__linux__)
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void PerfCounters::stop() {
+#if defined(__linux__)
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (int i = 0; i < EVENT_NB; i++) {
+        // Count, time enabled and time running, as asked for in the read format.
+        std::uint64_t values[3];
+        valid[i] = fds[i] >= 0 && read(fds[i], values, sizeof(values)) == sizeof(values)
+                && values[2] > 0;
+        if (valid[i]) {
+            counts[i] = std::uint64_t(double(values[0]) * values[1] / values[2]);
+        }
+    }
+#endif
+}
+
+void PerfCounters::reset() {
+#if defined(__linux__)
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+    }
+#endif
+    for (int i = 0; i < EVENT_NB; i++) {
+        counts[i] = 0;
+        valid[i]  = false;
+    }
+}
+
+std::string PerfCounters::report(std::uint64_t units, const std::string& unit) const {
+    std::ostringstream out;
+    if (!available()) {
+        out << "Perf counters   : unavailable (" << error << ")\n";
+        return out.str();
+    }
+    double per_unit = 1.0 / std::max<std::uint64_t>(units, 1);
+    out << std::fixed << std::setprecision(2);
+    for (int i = 0; i < EVENT_NB; i++) {
+        out << Events[i].label;
+        if (valid[i]) {
+            out << counts[i] << " (" << counts[i] * per_unit << "/" << unit << ")\n";
+        } else {
+            out << "unavailable\n";
+        }
+    }
+    if (valid[CYCLES] && valid[INSTRUCTIONS]) {
+        out << "IPC             : " << double(counts[INSTRUCTIONS]) / (counts[CYCLES] + 1)
+            << "\n";
+    }
+    return out.str();
+}
+
+std::string PerfCounters::summary(std::uint64_t units) const {
+    std::ostringstream out;
+    if (!available()) {
+        return "counters unavailable (" + error + ")";
+    }
+    double per_unit = 1.0 / std::max<std::uint64_t>(units, 1);
+    out << std::fixed << std::setprecision(2);
+    for (int i = 0; i < EVENT_NB; i++) {
+        if (valid[i]) {
+            out << Events[i].short_name << " " << counts[i] * per_unit << " ";
+        }
+    }
+    if (valid[CYCLES] && valid[INSTRUCTIONS]) {
+        out << "ipc " << double(counts[INSTRUCTIONS]) / (counts[CYCLES] + 1);
+    }
+    return out.str();
+}
+
+std::string PerfCounters::json() const {
+    std::ostringstream out;
+    out << "{";
+    for (int i = 0; i < EVENT_NB; i++) {
+        out << (i ? ", " : "") << "\"" << Events[i].json_name << "\": ";
+        if (valid[i]) {
+            out << counts[i];
+        } else {
+            out << "null";
+        }
+    }
+    out << "}";
+    return out.str();
+}
+
+} // namespace sonic
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace sonic {
+
+// Hardware counters of this process (and of the threads it starts while counting), read with
+// Linux perf_event_open. Counters that the kernel, the CPU or the permissions do not provide are
+// left out, and on other platforms none are available.
+class PerfCounters {
+   public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, EVENT_NB };
+
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Returns if at least one counter could be opened.
+    bool available() const;
+
+    // Enables the counters, which accumulate over start/stop pairs until reset.
+    void start();
+    // Disables the counters and reads them. Counts are scaled up if the kernel had to multiplex
+    // the counters.
+    void stop();
+    void reset();
+
+    // Returns one line per counter with its total and its count per unit (e.g. "node"), plus the
+    // IPC, aligned with the other bench statistics.
+    std::string report(std::uint64_t units, const std::string& unit) const;
+    // Returns the counts per unit on a single line.
+    std::string summary(std::uint64_t units) const;
+    // Returns the totals as a JSON object, with null for unavailable counters.
+    std::string json() const;
+
+   private:
+    int           fds[EVENT_NB];
+    std::uint64_t counts[EVENT_NB];
+    bool          valid[EVENT_NB];
+    std::string   error;
+};
+
+} // namespace sonic
@@ -1,16 +1,116 @@
 #include "perft.h"
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include "../chess/all.h"
 #include "../utils/timer.h"
+#include "perf_counters.h"
 
 namespace sonic {
 
+namespace {
+
+// Perft counts shared by all perft threads without locking. An entry stores its key XORed with its
+// data, so an entry torn by two concurrent writes fails the key check instead of returning a wrong
+// count.
+class PerftTable {
+   public:
+    explicit PerftTable(std::size_t mb_size) :
+        entries(mb_size * 1024 * 1024 / sizeof(Entry)) {}
+
+    bool probe(std::uint64_t key, int depth, std::uint64_t& count) const {
+        const Entry&  entry = entries[index(key, depth)];
+        std::uint64_t data  = entry.data.load(std::memory_order_relaxed);
+        std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || int(data & 0xFF) != depth) {
+            return false;
+        }
+        count = data >> 8;
+        return true;
+    }
+
+    void store(std::uint64_t key, int depth, std::uint64_t count) {
+        Entry&        entry = entries[index(key, depth)];
+        std::uint64_t data  = (count << 8) | std::uint64_t(depth);
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+   private:
+    struct Entry {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    // The same position at different depths goes to different entries.
+    std::size_t index(std::uint64_t key, int depth) const {
+        return (key ^ (depth * 0x9E3779B97F4A7C15ULL)) % entries.size();
+    }
+
+    std::vector<Entry> entries;
+};
+
+std::uint64_t perft(Position& pos, int depth, PerftTable* table) {
+    if (depth <= 1 || table == nullptr) {
+        return perft(pos, depth);
+    }
+    std::uint64_t node_count = 0;
+    if (table->probe(pos.hashkey(), depth, node_count)) {
+        return node_count;
+    }
+    MoveList movelist;
+    generate_moves<GenType::LEGAL>(pos, movelist);
+    for (const Move& m : movelist) {
+        UndoInfo info;
+        pos.make_move(m, info);
+        node_count += perft(pos, depth - 1, table);
+        pos.unmake_move(info);
+    }
+    table->store(pos.hashkey(), depth, node_count);
+    return node_count;
+}
+
+// Returns the perft count below each legal move of `pos`, with the moves split across `threads`
+// threads.
+std::vector<std::uint64_t> perft_root_moves(const Position& pos,
+                                            const MoveList& movelist,
+                                            int             depth,
+                                            int             threads,
+                                            PerftTable*     table) {
+    std::vector<std::uint64_t> counts(movelist.size());
+    std::atomic<std::size_t>   next_move(0);
+    std::vector<std::thread>   workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            Position worker_pos = pos;
+            // Each thread takes the next root move that has not been started.
+            for (std::size_t i = next_move++; i < movelist.size(); i = next_move++) {
+                UndoInfo info;
+                worker_pos.make_move(movelist[i], info);
+                counts[i] = perft(worker_pos, depth - 1, table);
+                worker_pos.unmake_move(info);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return counts;
+}
+
+std::unique_ptr<PerftTable> make_table(int hash_mb) {
+    return hash_mb > 0 ? std::make_unique<PerftTable>(hash_mb) : nullptr;
+}
+
+} // namespace
+
 // Count number of leaf nodes.
 std::uint64_t perft(Position& pos, int depth) {
     if (depth == 0) {
@@ -18,13 +118,13 @@ std::uint64_t perft(Position& pos, int depth) {
     }
     std::uint64_t node_count = 0;
     MoveList      movelist;
-    generate_moves<GenType::ALL>(pos, movelist);
+    generate_moves<GenType::LEGAL>(pos, movelist);
+    if (depth == 1) {
+        return movelist.size();
+    }
     for (const Move& m : movelist) {
         UndoInfo info;
-        if (!pos.make_move(m, info)) {
-            pos.unmake_move(info);
-            continue;
-        }
+        pos.make_move(m, info);
         std::uint64_t count = perft(pos, depth - 1);
         node_count += count;
         pos.unmake_move(info);
@@ -32,7 +132,42 @@ std::uint64_t perft(Position& pos, int depth) {
     return node_count;
 }
 
-void bench_perft() {
+void perft_divide(const Position& pos,
+                  int             depth,
+                  int             threads,
+                  int             hash_mb,
+                  bool            with_counters) {
+    MoveList movelist;
+    generate_moves<GenType::LEGAL>(pos, movelist);
+    std::unique_ptr<PerftTable>   table = make_table(hash_mb);
+    std::unique_ptr<PerfCounters> counters(with_counters ? new PerfCounters() : nullptr);
+
+    TimePoint start = current_time();
+    if (counters) {
+        counters->start();
+    }
+    std::vector<std::uint64_t> counts = perft_root_moves(pos, movelist, depth, threads,
+                                                         table.get());
+    if (counters) {
+        counters->stop();
+    }
+    std::uint64_t ms = time_elapsed(start);
+
+    std::uint64_t node_count = 0;
+    for (std::size_t i = 0; i < movelist.size(); i++) {
+        std::cout << movelist[i].to_string() << ": " << counts[i] << std::endl;
+        node_count += counts[i];
+    }
+    std::cout << std::endl;
+    std::cout << "Nodes searched  : " << node_count << std::endl;
+    std::cout << "Total time (ms) : " << ms << std::endl;
+    std::cout << "Nodes/second    : " << (node_count * 1000) / (ms + 1) << std::endl;
+    if (counters) {
+        std::cout << counters->report(node_count, "node") << std::flush;
+    }
+}
+
+void bench_perft(bool deep, int threads, int hash_mb, bool with_counters) {
     // clang-format off
     const std::vector<PerftTest> perft_tests = {
         {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 119060324ULL, 6},
@@ -43,17 +178,40 @@ void bench_perft() {
         {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 89941194ULL, 5},
         {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 164075551ULL, 5},
     };
+    const std::vector<PerftTest> deep_perft_tests = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 3195901860ULL, 7},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 8031647685ULL, 6},
+        {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 3009794393ULL, 8},
+        {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 6923051137ULL, 6},
+    };
     // clang-format on
+    const std::vector<PerftTest>& tests = (deep ? deep_perft_tests : perft_tests);
 
-    for (std::size_t i = 0; i < perft_tests.size(); i++) {
-        const auto& test = perft_tests[i];
-        Position    pos(test.fen);
+    std::uint64_t                 total_nodes = 0, total_ms = 0;
+    std::unique_ptr<PerfCounters> counters(with_counters ? new PerfCounters() : nullptr);
+    for (std::size_t i = 0; i < tests.size(); i++) {
+        const auto&                 test  = tests[i];
+        Position                    pos(test.fen);
+        MoveList                    movelist;
+        std::unique_ptr<PerftTable> table = make_table(hash_mb);
+        generate_moves<GenType::LEGAL>(pos, movelist);
 
-        TimePoint     start      = current_time();
-        std::uint64_t node_count = perft(pos, test.depth);
-        std::uint64_t ms         = time_elapsed(start);
+        TimePoint start = current_time();
+        if (counters) {
+            counters->start();
+        }
+        std::vector<std::uint64_t> counts =
+            perft_root_moves(pos, movelist, test.depth, threads, table.get());
+        if (counters) {
+            counters->stop();
+        }
+        std::uint64_t node_count = 0;
+        for (std::uint64_t count : counts) {
+            node_count += count;
+        }
+        std::uint64_t ms = time_elapsed(start);
 
-        std::cout << "Position [" << i + 1 << "/" << perft_tests.size() << "]:";
+        std::cout << "Position [" << i + 1 << "/" << tests.size() << "]:";
         std::cout << std::left;
         std::cout << " depth " << std::setw(2) << test.depth;
         std::cout << " time " << std::setw(5) << ms;
@@ -61,7 +219,15 @@ void bench_perft() {
         std::cout << " nps " << std::setw(9) << (node_count * 1000) / (ms + 1);
         std::cout << " fen " << std::setw(87) << test.fen << std::endl;
         assert(node_count == test.expected_node_count);
+        total_nodes += node_count;
+        total_ms += ms;
+    }
+    std::cout << "Total nodes " << total_nodes << " time " << total_ms << " nps "
+              << (total_nodes * 1000) / (total_ms + 1) << " ("
+              << (use_copy_make ? "copy-make" : "make/unmake") << ")" << std::endl;
+    if (counters) {
+        std::cout << counters->report(total_nodes, "node") << std::flush;
     }
 }
 
-} // namespace sonic
\ No newline at end of file
+} // namespace sonic
@@ -13,7 +13,25 @@ struct PerftTest {
     int           depth;
 };
 
+// Counts the leaf nodes `depth` plies below `pos`. The last ply is counted from the size of the
+// legal move list instead of being played.
 std::uint64_t perft(Position& pos, int depth);
-void          bench_perft();
+
+// Prints the perft count below each root move and the total. Root moves are split across
+// `threads` threads, which share a perft hash table of `hash_mb` MB (none if 0). With
+// `with_counters` the hardware counters of the run are reported too.
+// Usage: perft <depth> [threads] [hash] [counters]
+void perft_divide(const Position& pos,
+                  int             depth,
+                  int             threads,
+                  int             hash_mb,
+                  bool            with_counters = false);
+
+// Runs the perft suite, or the deeper suite that needs a hash table to finish quickly.
+// Usage: perft [deep [threads] [hash]] [counters]
+void bench_perft(bool deep          = false,
+                 int  threads       = 1,
+                 int  hash_mb       = 0,
+                 bool with_counters = false);
 
 } // namespace sonic
\ No newline at end of file
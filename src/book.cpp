@@ -44,8 +44,6 @@ Move Book::book_move(const Position& pos) const {
         }
         return Move(from, to, promotion);
     };
-    MoveList movelist;
-    generate_moves<GenType::ALL>(pos, movelist);
     Move best_move  = MOVE_NONE;
     int  best_score = 0;
     for (int i = find_key(pos.hashkey()); i < book_size; i++) {
@@ -53,9 +51,10 @@ Move Book::book_move(const Position& pos) const {
         if (entry.key != pos.hashkey()) {
             break;
         }
-        Move move = convert_move(entry.move);
-        // Check if the given move is in movelist. This can filter out chess960 moves.
-        if (!movelist.contains(move)) {
+        // Match against the legal moves to get the move flags. This also filters out chess960
+        // moves.
+        Move move = find_legal_move(pos, convert_move(entry.move));
+        if (move == MOVE_NONE) {
             continue;
         }
         int score = entry.count;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "attackinfo.h"
 #include "attacks.h"
 #include "bitboard.h"
 #include "castling.h"
@@ -0,0 +1,110 @@
+#include "attackinfo.h"
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "color.h"
+#include "piece.h"
+#include "position.h"
+
+namespace sonic {
+
+AttackInfo::AttackInfo(const Position& pos) :
+    pos(pos) {
+    Color us   = pos.side_to_move();
+    checkersBB = pos.attackers_to(pos.king_square(us), other_color(us), pos.pieces());
+}
+
+namespace {
+
+// Returns the pieces of `owner` that are the only piece between `king` and a slider of `attacker`.
+Bitboard slider_blockers(const Position& pos, Square king, Color attacker, Color owner) {
+    Bitboard occupied = pos.pieces();
+    Bitboard queens   = pos.pieces(attacker, PieceType::QUEEN);
+    Bitboard rooks    = pos.pieces(attacker, PieceType::ROOK) | queens;
+    Bitboard bishops  = pos.pieces(attacker, PieceType::BISHOP) | queens;
+    // Sliders that would attack the king on an empty board.
+    Bitboard snipers = (rook_attacks(king, Bitboard(0)) & rooks)
+                     | (bishop_attacks(king, Bitboard(0)) & bishops);
+    Bitboard result = Bitboard(0);
+    for (Square sniper : snipers) {
+        Bitboard blockers = between_bb[king.to_int()][sniper.to_int()] & occupied;
+        if (blockers.count() == 1) {
+            result += blockers & pos.pieces(owner);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void AttackInfo::compute_pinned() {
+    Color us    = pos.side_to_move();
+    pinnedBB    = slider_blockers(pos, pos.king_square(us), other_color(us), us);
+    pinnedReady = true;
+}
+
+void AttackInfo::compute_discoverers() {
+    Color us         = pos.side_to_move();
+    Color them       = other_color(us);
+    discoverersBB    = slider_blockers(pos, pos.king_square(them), us, us);
+    discoverersReady = true;
+}
+
+void AttackInfo::compute_king_danger() {
+    Color    us       = pos.side_to_move();
+    Color    them     = other_color(us);
+    Bitboard occupied = pos.pieces() - pos.king_square(us);
+    dangerBB          = king_attacks[pos.king_square(them).to_int()];
+    for (Square sq : pos.pieces(them, PieceType::PAWN)) {
+        dangerBB += pawn_attacks[them][sq.to_int()];
+    }
+    for (Square sq : pos.pieces(them, PieceType::KNIGHT)) {
+        dangerBB += knight_attacks[sq.to_int()];
+    }
+    for (Square sq : pos.pieces(them, PieceType::BISHOP) | pos.pieces(them, PieceType::QUEEN)) {
+        dangerBB += bishop_attacks(sq, occupied);
+    }
+    for (Square sq : pos.pieces(them, PieceType::ROOK) | pos.pieces(them, PieceType::QUEEN)) {
+        dangerBB += rook_attacks(sq, occupied);
+    }
+    dangerReady = true;
+}
+
+void AttackInfo::compute_attack_maps() {
+    Bitboard occupied = pos.pieces();
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        Bitboard pawn_attacks_bb = 0;
+        for (Square sq : pos.pieces(c, PieceType::PAWN)) {
+            pawn_attacks_bb += pawn_attacks[c][sq.to_int()];
+        }
+        attacksBB[c][PieceType::PAWN] = pawn_attacks_bb;
+        for (PieceType pt : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK,
+                             PieceType::QUEEN}) {
+            Bitboard piece_attacks = 0;
+            for (Square sq : pos.pieces(c, pt)) {
+                Bitboard attacks = 0;
+                if (pt == PieceType::KNIGHT) {
+                    attacks = knight_attacks[sq.to_int()];
+                }
+                if (pt == PieceType::BISHOP || pt == PieceType::QUEEN) {
+                    attacks += bishop_attacks(sq, occupied);
+                }
+                if (pt == PieceType::ROOK || pt == PieceType::QUEEN) {
+                    attacks += rook_attacks(sq, occupied);
+                }
+                attacksFrom[sq.to_int()] = attacks;
+                piece_attacks += attacks;
+            }
+            attacksBB[c][pt] = piece_attacks;
+        }
+        attacksBB[c][PieceType::KING] = king_attacks[pos.king_square(c).to_int()];
+        attackedBB[c]                 = attacksBB[c][PieceType::PAWN];
+        for (PieceType pt : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK,
+                             PieceType::QUEEN, PieceType::KING}) {
+            attackedBB[c] += attacksBB[c][pt];
+        }
+    }
+    mapsReady = true;
+}
+
+} // namespace sonic
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "bitboard.h"
+#include "color.h"
+#include "piece.h"
+#include "position.h"
+
+namespace sonic {
+
+// Attack information of a position, shared by evaluation, check detection and move generation.
+// Each part is computed on first use, so the position must not change while the object is alive.
+class AttackInfo {
+   public:
+    explicit AttackInfo(const Position& pos);
+
+    // Pieces giving check to the side to move.
+    Bitboard checkers() const { return checkersBB; }
+    bool     in_check() const { return checkersBB.any(); }
+
+    // Pieces of the side to move that are absolutely pinned to their king.
+    Bitboard pinned() {
+        if (!pinnedReady) {
+            compute_pinned();
+        }
+        return pinnedBB;
+    }
+
+    // Pieces of the side to move blocking one of its own sliders from the enemy king, which give a
+    // discovered check when they leave the line.
+    Bitboard discoverers() {
+        if (!discoverersReady) {
+            compute_discoverers();
+        }
+        return discoverersBB;
+    }
+
+    // Squares attacked by the opponent with the king of the side to move removed from the board,
+    // i.e. the squares the king cannot move to.
+    Bitboard king_danger() {
+        if (!dangerReady) {
+            compute_king_danger();
+        }
+        return dangerBB;
+    }
+
+    // Squares attacked by the knight, bishop, rook or queen on `sq`.
+    Bitboard attacks_from(Square sq) {
+        compute_maps();
+        return attacksFrom[sq.to_int()];
+    }
+
+    // Squares attacked by pieces of type `pt` owned by `c`.
+    Bitboard attacks(Color c, PieceType pt) {
+        compute_maps();
+        return attacksBB[c][pt];
+    }
+
+    // Squares attacked by `c`.
+    Bitboard attacks(Color c) {
+        compute_maps();
+        return attackedBB[c];
+    }
+
+   private:
+    void compute_maps() {
+        if (!mapsReady) {
+            compute_attack_maps();
+        }
+    }
+
+    void compute_pinned();
+    void compute_discoverers();
+    void compute_king_danger();
+    void compute_attack_maps();
+
+    const Position& pos;
+    Bitboard        checkersBB;
+    Bitboard        pinnedBB;
+    Bitboard        discoverersBB;
+    Bitboard        dangerBB;
+    bool            pinnedReady      = false;
+    bool            discoverersReady = false;
+    bool            dangerReady      = false;
+    bool            mapsReady        = false;
+    Bitboard        attacksBB[Color::COLOR_NB][PieceType::PIECE_NB];
+    Bitboard        attackedBB[Color::COLOR_NB];
+    Bitboard        attacksFrom[Square::SQ_NB];
+};
+
+} // namespace sonic
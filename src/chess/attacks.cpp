@@ -1,202 +1,191 @@
 #include "attacks.h"
 
+#if defined(SONIC_PEXT_ASM)
+#include <cpuid.h>
+#endif
+
 #include "bitboard.h"
 #include "color.h"
 
 namespace sonic {
 
-Bitboard    rook_rays[Square::SQ_NB];
-Magic<4096> rook_magics[Square::SQ_NB];
-Bitboard    bishop_rays[Square::SQ_NB];
-Magic<512>  bishop_magics[Square::SQ_NB];
-
-void init_rook_attacks() {
-    for (int file = 0; file < 8; file++) {
-        for (int rank = 0; rank < 8; rank++) {
-            Bitboard rays_bb(0);
-
-            // North
-            for (int new_rank = rank + 1; new_rank < 7; new_rank++) {
-                rays_bb += Square(File(file), Rank(new_rank));
-            }
-
-            // South
-            for (int new_rank = rank - 1; new_rank > 0; new_rank--) {
-                rays_bb += Square(File(file), Rank(new_rank));
-            }
-
-            // West
-            for (int new_file = file - 1; new_file > 0; new_file--) {
-                rays_bb += Square(File(new_file), Rank(rank));
-            }
-
-            // East
-            for (int new_file = file + 1; new_file < 7; new_file++) {
-                rays_bb += Square(File(new_file), Rank(rank));
-            }
+namespace {
 
-            Square sq              = Square(File(file), Rank(rank));
-            rook_rays[sq.to_int()] = rays_bb;
-
-            // Iterate over all submask of rays to fill magic table.
-            for (std::uint64_t blockers = rays_bb.to_int();;
-                 blockers               = (blockers - 1) & rays_bb.to_int()) {
-                const Bitboard& blockers_bb(blockers);
-                Bitboard        attacks_bb = 0;
-
-                // North
-                for (int new_rank = rank + 1; Square::is_valid(new_rank, file); new_rank++) {
-                    Square cur = Square(File(file), Rank(new_rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
+// Steps of the rook (first four) and the bishop (last four) as {file, rank} offsets. The first
+// two directions of each piece move towards higher squares.
+constexpr int Steps[8][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
 
-                // South
-                for (int new_rank = rank - 1; Square::is_valid(new_rank, file); new_rank--) {
-                    Square cur = Square(File(file), Rank(new_rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
+constexpr int ROOK   = 0;
+constexpr int BISHOP = 4;
 
-                // West
-                for (int new_file = file - 1; Square::is_valid(rank, new_file); new_file--) {
-                    Square cur = Square(File(new_file), Rank(rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
-
-                // East
-                for (int new_file = file + 1; Square::is_valid(rank, new_file); new_file++) {
-                    Square cur = Square(File(new_file), Rank(rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
-
-                // Update magic table.
-                std::uint64_t key =
-                    (blockers * rook_multiplies[sq.to_int()]) >> rook_shifts[sq.to_int()];
-                rook_magics[sq.to_int()].ray_mask     = rays_bb;
-                rook_magics[sq.to_int()].magic        = rook_multiplies[sq.to_int()];
-                rook_magics[sq.to_int()].shift        = rook_shifts[sq.to_int()];
-                rook_magics[sq.to_int()].attacks[key] = attacks_bb;
+constexpr bool on_board(int file, int rank) {
+    return 0 <= file && file < 8 && 0 <= rank && rank < 8;
+}
 
-                if (blockers == 0) {
-                    break;
-                }
+// Squares from `sq` to the edge of the board, excluding `sq`, for each piece and direction.
+constexpr std::array<std::array<std::array<std::uint64_t, Square::SQ_NB>, 4>, 2> make_rays() {
+    std::array<std::array<std::array<std::uint64_t, Square::SQ_NB>, 4>, 2> rays{};
+    for (int dir = 0; dir < 8; dir++) {
+        for (int sq = 0; sq < Square::SQ_NB; sq++) {
+            int file = sq % 8 + Steps[dir][0];
+            int rank = sq / 8 + Steps[dir][1];
+            for (; on_board(file, rank); file += Steps[dir][0], rank += Steps[dir][1]) {
+                rays[dir / 4][dir % 4][sq] |= std::uint64_t(1) << (rank * 8 + file);
             }
         }
     }
+    return rays;
 }
 
-void init_bishop_attacks() {
-    for (int file = 0; file < 8; file++) {
-        for (int rank = 0; rank < 8; rank++) {
-            Bitboard rays_bb(0);
-
-            // North West
-            for (int new_file = file - 1, new_rank = rank + 1; new_file > 0 && new_rank < 7;
-                 new_file--, new_rank++) {
-                Square cur = Square(File(new_file), Rank(new_rank));
-                rays_bb += cur;
-            }
-
-            // North East
-            for (int new_file = file + 1, new_rank = rank + 1; new_file < 7 && new_rank < 7;
-                 new_file++, new_rank++) {
-                Square cur = Square(File(new_file), Rank(new_rank));
-                rays_bb += cur;
-            }
-
-            // South West
-            for (int new_file = file - 1, new_rank = rank - 1; new_file > 0 && new_rank > 0;
-                 new_file--, new_rank--) {
-                Square cur = Square(File(new_file), Rank(new_rank));
-                rays_bb += cur;
-            }
+constexpr auto Rays = make_rays();
+
+// Squares attacked by a rook (piece == ROOK) or bishop (piece == BISHOP) on `sq`, stopped by
+// `occupied`. Each ray is cut behind its nearest blocker.
+constexpr std::uint64_t sliding_attacks(int piece, int sq, std::uint64_t occupied) {
+    const auto&   rays    = Rays[piece / 4];
+    std::uint64_t attacks = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        std::uint64_t ray      = rays[dir][sq];
+        std::uint64_t blockers = ray & occupied;
+        if (blockers) {
+            ray ^= rays[dir][dir < 2 ? __builtin_ctzll(blockers) : 63 - __builtin_clzll(blockers)];
+        }
+        attacks |= ray;
+    }
+    return attacks;
+}
 
-            // South East
-            for (int new_file = file + 1, new_rank = rank - 1; new_file < 7 && new_rank > 0;
-                 new_file++, new_rank--) {
-                Square cur = Square(File(new_file), Rank(new_rank));
-                rays_bb += cur;
-            }
+// Squares whose occupancy matters for a slider on `sq`: the rays without the board edges.
+constexpr std::uint64_t relevant_rays(int piece, int sq) {
+    std::uint64_t rays = 0;
+    for (int dir = piece; dir < piece + 4; dir++) {
+        int file = sq % 8 + Steps[dir][0];
+        int rank = sq / 8 + Steps[dir][1];
+        for (; on_board(file + Steps[dir][0], rank + Steps[dir][1]);
+             file += Steps[dir][0], rank += Steps[dir][1]) {
+            rays |= std::uint64_t(1) << (rank * 8 + file);
+        }
+    }
+    return rays;
+}
 
-            Square sq                = Square(File(file), Rank(rank));
-            bishop_rays[sq.to_int()] = rays_bb;
-
-            // Iterate over all submask of rays to fill magic table.
-            for (std::uint64_t blockers = rays_bb.to_int();;
-                 blockers               = (blockers - 1) & rays_bb.to_int()) {
-                const Bitboard& blockers_bb(blockers);
-                Bitboard        attacks_bb = 0;
-
-                // North West
-                for (int new_file = file - 1, new_rank = rank + 1;
-                     Square::is_valid(new_rank, new_file); new_file--, new_rank++) {
-                    Square cur = Square(File(new_file), Rank(new_rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
+constexpr std::array<Magic, Square::SQ_NB> make_magics(int                  piece,
+                                                       const std::uint64_t* multiplies,
+                                                       const int*           shifts,
+                                                       unsigned             offset) {
+    std::array<Magic, Square::SQ_NB> magics{};
+    for (int sq = 0; sq < Square::SQ_NB; sq++) {
+        magics[sq].ray_mask = relevant_rays(piece, sq);
+        magics[sq].magic    = multiplies[sq];
+        magics[sq].shift    = shifts[sq];
+        magics[sq].offset   = offset;
+        offset += 1u << (64 - shifts[sq]);
+    }
+    return magics;
+}
 
-                // North East
-                for (int new_file = file + 1, new_rank = rank + 1;
-                     Square::is_valid(new_rank, new_file); new_file++, new_rank++) {
-                    Square cur = Square(File(new_file), Rank(new_rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
+// Fills the attack sets of all squares, indexed by magic multiplication or by PEXT.
+template<bool Pext>
+constexpr void fill_slider_attacks(std::array<Bitboard, SLIDER_TABLE_SIZE>& table,
+                                   const std::array<Magic, Square::SQ_NB>& magics,
+                                   int                                     piece) {
+    for (int sq = 0; sq < Square::SQ_NB; sq++) {
+        const Magic&  m    = magics[sq];
+        std::uint64_t mask = m.ray_mask.to_int();
+        // Enumerates the subsets of the mask in increasing order of their PEXT index.
+        std::uint64_t blockers = 0, index = 0;
+        do {
+            std::uint64_t key     = Pext ? index++ : (blockers * m.magic) >> m.shift;
+            table[m.offset + key] = sliding_attacks(piece, sq, blockers);
+            blockers              = (blockers - mask) & mask;
+        } while (blockers);
+    }
+}
 
-                // South West
-                for (int new_file = file - 1, new_rank = rank - 1;
-                     Square::is_valid(new_rank, new_file); new_file--, new_rank--) {
-                    Square cur = Square(File(new_file), Rank(new_rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
-                }
+template<bool Pext>
+constexpr std::array<Bitboard, SLIDER_TABLE_SIZE> make_slider_attacks(
+    const std::array<Magic, Square::SQ_NB>& rooks,
+    const std::array<Magic, Square::SQ_NB>& bishops) {
+    std::array<Bitboard, SLIDER_TABLE_SIZE> table{};
+    fill_slider_attacks<Pext>(table, rooks, ROOK);
+    fill_slider_attacks<Pext>(table, bishops, BISHOP);
+    return table;
+}
 
-                // South East
-                for (int new_file = file + 1, new_rank = rank - 1;
-                     Square::is_valid(new_rank, new_file); new_file++, new_rank--) {
-                    Square cur = Square(File(new_file), Rank(new_rank));
-                    attacks_bb += cur;
-                    if (blockers_bb.get(cur)) {
-                        break;
-                    }
+// Returns the squares strictly between (Between) or on the whole line through (!Between) two
+// aligned squares.
+template<bool Between>
+constexpr SquareTable make_line_table() {
+    SquareTable table{};
+    for (int a = 0; a < Square::SQ_NB; a++) {
+        for (int piece : {ROOK, BISHOP}) {
+            std::uint64_t a_attacks = sliding_attacks(piece, a, 0);
+            for (int b = 0; b < Square::SQ_NB; b++) {
+                if (!(a_attacks & (std::uint64_t(1) << b))) {
+                    continue;
                 }
-
-                // Update magic table.
-                std::uint64_t key =
-                    (blockers * bishop_multiplies[sq.to_int()]) >> bishop_shifts[sq.to_int()];
-                bishop_magics[sq.to_int()].ray_mask     = rays_bb;
-                bishop_magics[sq.to_int()].magic        = bishop_multiplies[sq.to_int()];
-                bishop_magics[sq.to_int()].shift        = bishop_shifts[sq.to_int()];
-                bishop_magics[sq.to_int()].attacks[key] = attacks_bb;
-
-                if (blockers == 0) {
-                    break;
+                std::uint64_t a_bb = std::uint64_t(1) << a;
+                std::uint64_t b_bb = std::uint64_t(1) << b;
+                if (Between) {
+                    table[a][b] = sliding_attacks(piece, a, b_bb) & sliding_attacks(piece, b, a_bb);
+                } else {
+                    table[a][b] = (a_attacks & sliding_attacks(piece, b, 0)) | a_bb | b_bb;
                 }
             }
         }
     }
+    return table;
 }
 
-void init_attacks() {
-    init_rook_attacks();
-    init_bishop_attacks();
+#if !defined(USE_PEXT)
+// Returns if the CPU has a fast PEXT: it supports BMI2 and is not an AMD CPU before Zen 3
+// (family 0x19), where PEXT is microcoded and slower than magic multiplication.
+bool cpu_has_fast_pext() {
+#if defined(SONIC_PEXT_ASM)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !((ebx >> 8) & 1)) {
+        return false;
+    }
+    __get_cpuid(0, &eax, &ebx, &ecx, &edx);
+    bool amd = (ebx == 0x68747541 && edx == 0x69746e65 && ecx == 0x444d4163); // "AuthenticAMD"
+    if (!amd) {
+        return true;
+    }
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    unsigned int family = (eax >> 8) & 0xF;
+    if (family == 0xF) {
+        family += (eax >> 20) & 0xFF;
+    }
+    return family >= 0x19;
+#else
+    return false;
+#endif
 }
-
-} // namespace sonic
\ No newline at end of file
+#endif
+
+} // namespace
+
+#if defined(USE_PEXT)
+const bool use_pext = true;
+#else
+const bool use_pext = cpu_has_fast_pext();
+#endif
+
+constexpr std::array<Magic, Square::SQ_NB> rook_magics =
+    make_magics(ROOK, rook_multiplies, rook_shifts, 0);
+constexpr std::array<Magic, Square::SQ_NB> bishop_magics =
+    make_magics(BISHOP, bishop_multiplies, bishop_shifts, ROOK_TABLE_SIZE);
+
+#if !defined(USE_PEXT)
+constexpr std::array<Bitboard, SLIDER_TABLE_SIZE> magic_attacks =
+    make_slider_attacks<false>(rook_magics, bishop_magics);
+#endif
+#if defined(USE_PEXT) || defined(SONIC_PEXT_ASM)
+constexpr std::array<Bitboard, SLIDER_TABLE_SIZE> pext_attacks =
+    make_slider_attacks<true>(rook_magics, bishop_magics);
+#endif
+
+constexpr SquareTable between_bb = make_line_table<true>();
+constexpr SquareTable line_bb    = make_line_table<false>();
+
+} // namespace sonic
@@ -1,33 +1,97 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 #include "bitboard.h"
 #include "color.h"
 
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(NO_PEXT)
+// PEXT is emitted with inline assembly so the default build can pick it at runtime.
+#define SONIC_PEXT_ASM
+#endif
+
 namespace sonic {
 
-template<std::size_t N>
+#if defined(USE_PEXT) || defined(SONIC_PEXT_ASM)
+// Extracts the bits of `x` selected by `mask` into the low bits of the result.
+inline std::uint64_t pext(std::uint64_t x, std::uint64_t mask) {
+#if defined(USE_PEXT)
+    return _pext_u64(x, mask);
+#else
+    std::uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(x), "r"(mask));
+    return result;
+#endif
+}
+#endif
+
+// True when slider attacks are indexed with PEXT instead of magic multiplication.
+// Always true when built with USE_PEXT, otherwise detected at startup with CPUID.
+extern const bool use_pext;
+
+// Number of attack table entries over all squares, see rook_shifts and bishop_shifts.
+constexpr std::size_t ROOK_TABLE_SIZE   = 0x19000;
+constexpr std::size_t BISHOP_TABLE_SIZE = 0x1480;
+constexpr std::size_t SLIDER_TABLE_SIZE = ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE;
+
+// Attack sets of all rook squares followed by all bishop squares, indexed by magic
+// multiplication and by PEXT respectively. All tables are generated at compile time.
+#if !defined(USE_PEXT)
+extern const std::array<Bitboard, SLIDER_TABLE_SIZE> magic_attacks;
+#endif
+#if defined(USE_PEXT) || defined(SONIC_PEXT_ASM)
+extern const std::array<Bitboard, SLIDER_TABLE_SIZE> pext_attacks;
+#endif
+
+// "Fancy" magic: each square owns 2^(64 - shift) consecutive entries of the shared slider
+// tables starting at `offset`.
 struct Magic {
-    Bitboard                ray_mask;
-    std::uint64_t           magic;
-    std::uint64_t           shift;
-    std::array<Bitboard, N> attacks;
+    Bitboard      ray_mask;
+    std::uint64_t magic;
+    unsigned      shift;
+    unsigned      offset;
 
     Bitboard operator()(Bitboard occupied) const {
+#if defined(USE_PEXT)
+        return pext_attacks[offset + pext(occupied.to_int(), ray_mask.to_int())];
+#else
+#if defined(SONIC_PEXT_ASM)
+        if (use_pext) {
+            return pext_attacks[offset + pext(occupied.to_int(), ray_mask.to_int())];
+        }
+#endif
         occupied &= ray_mask;
-        std::uint64_t key = (occupied.to_int() * magic) >> shift;
-        return attacks[key];
+        return magic_attacks[offset + ((occupied.to_int() * magic) >> shift)];
+#endif
     }
 };
 
-extern Bitboard    rook_rays[Square::SQ_NB];
-extern Magic<4096> rook_magics[Square::SQ_NB];
-extern Bitboard    bishop_rays[Square::SQ_NB];
-extern Magic<512>  bishop_magics[Square::SQ_NB];
+extern const std::array<Magic, Square::SQ_NB> rook_magics;
+extern const std::array<Magic, Square::SQ_NB> bishop_magics;
+
+inline Bitboard rook_attacks(Square sq, Bitboard occupied) {
+    return rook_magics[sq.to_int()](occupied);
+}
+
+inline Bitboard bishop_attacks(Square sq, Bitboard occupied) {
+    return bishop_magics[sq.to_int()](occupied);
+}
+
+inline Bitboard queen_attacks(Square sq, Bitboard occupied) {
+    return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+}
+
+using SquareTable = std::array<std::array<Bitboard, Square::SQ_NB>, Square::SQ_NB>;
+
+// Squares strictly between two squares on the same line, empty otherwise.
+extern const SquareTable between_bb;
 
-void init_attacks();
+// The whole line through two squares, including both, empty if they are not aligned.
+extern const SquareTable line_bb;
 
 // clang-format off
 // Magic numbers for rook.
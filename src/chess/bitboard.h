@@ -94,6 +94,13 @@ class Square {
     std::uint8_t square = 0;
 };
 
+// Returns the Chebyshev distance between two squares (number of king moves).
+constexpr int distance(Square a, Square b) {
+    int row_diff = a.row() > b.row() ? a.row() - b.row() : b.row() - a.row();
+    int col_diff = a.col() > b.col() ? a.col() - b.col() : b.col() - a.col();
+    return row_diff > col_diff ? row_diff : col_diff;
+}
+
 class Bitboard {
    public:
     constexpr Bitboard() {}
@@ -187,6 +194,10 @@ class Bitboard {
         return Bitboard(a.board | b.board);
     }
 
+    friend constexpr Bitboard operator^(const Bitboard& a, const Bitboard& b) {
+        return Bitboard(a.board ^ b.board);
+    }
+
     friend constexpr Bitboard operator+(const Bitboard& a, const Square& b) {
         return Bitboard(a.board | b.to_bb());
     }
@@ -205,6 +216,11 @@ class Bitboard {
         return *this;
     }
 
+    constexpr Bitboard& operator^=(const Bitboard& b) {
+        board ^= b.board;
+        return *this;
+    }
+
     constexpr Bitboard& operator-=(const Bitboard& b) {
         board &= ~b.board;
         return *this;
@@ -227,4 +243,36 @@ class Bitboard {
     std::uint64_t board = 0;
 };
 
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB.to_int() << 7;
+
+constexpr Bitboard rank_bb(Rank r) { return Bitboard(0xFFULL << (8 * r)); }
+constexpr Bitboard file_bb(File f) { return Bitboard(FILE_A_BB.to_int() << f); }
+
+// Moves every square of `b` one step towards `D`, dropping the squares that leave the board.
+template<Direction D>
+constexpr Bitboard shift(Bitboard b) {
+    constexpr std::uint64_t not_file_a = ~FILE_A_BB.to_int();
+    constexpr std::uint64_t not_file_h = ~FILE_H_BB.to_int();
+    std::uint64_t           bb         = b.to_int();
+    if constexpr (D == Direction::NORTH) {
+        return bb << 8;
+    } else if constexpr (D == Direction::SOUTH) {
+        return bb >> 8;
+    } else if constexpr (D == Direction::NORTH_EAST) {
+        return (bb & not_file_h) << 9;
+    } else if constexpr (D == Direction::NORTH_WEST) {
+        return (bb & not_file_a) << 7;
+    } else if constexpr (D == Direction::SOUTH_EAST) {
+        return (bb & not_file_h) >> 7;
+    } else if constexpr (D == Direction::SOUTH_WEST) {
+        return (bb & not_file_a) >> 9;
+    } else if constexpr (D == Direction::EAST) {
+        return (bb & not_file_h) << 1;
+    } else {
+        static_assert(D == Direction::WEST);
+        return (bb & not_file_a) >> 1;
+    }
+}
+
 } // namespace sonic
\ No newline at end of file
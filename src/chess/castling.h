@@ -18,16 +18,24 @@ class Castling {
     static constexpr Square   WHITE_000_EXTRA_SQ = SQ_B1;
     static constexpr Square   BLACK_000_EXTRA_SQ = SQ_B8;
 
-    static constexpr Move WHITE_00_MOVE  = Move(SQ_E1, SQ_G1);
-    static constexpr Move WHITE_000_MOVE = Move(SQ_E1, SQ_C1);
-    static constexpr Move BLACK_00_MOVE  = Move(SQ_E8, SQ_G8);
-    static constexpr Move BLACK_000_MOVE = Move(SQ_E8, SQ_C8);
+    static constexpr Move WHITE_00_MOVE  = Move(SQ_E1, SQ_G1, Move::KING_CASTLE);
+    static constexpr Move WHITE_000_MOVE = Move(SQ_E1, SQ_C1, Move::QUEEN_CASTLE);
+    static constexpr Move BLACK_00_MOVE  = Move(SQ_E8, SQ_G8, Move::KING_CASTLE);
+    static constexpr Move BLACK_000_MOVE = Move(SQ_E8, SQ_C8, Move::QUEEN_CASTLE);
 
     static constexpr Move WHITE_00_ROOK_MOVE  = Move(SQ_H1, SQ_F1);
     static constexpr Move WHITE_000_ROOK_MOVE = Move(SQ_A1, SQ_D1);
     static constexpr Move BLACK_00_ROOK_MOVE  = Move(SQ_H8, SQ_F8);
     static constexpr Move BLACK_000_ROOK_MOVE = Move(SQ_A8, SQ_D8);
 
+    // Rook move of castling king side and queen side for `c`.
+    static constexpr Move rook_00_move(Color c) {
+        return c == Color::WHITE ? WHITE_00_ROOK_MOVE : BLACK_00_ROOK_MOVE;
+    }
+    static constexpr Move rook_000_move(Color c) {
+        return c == Color::WHITE ? WHITE_000_ROOK_MOVE : BLACK_000_ROOK_MOVE;
+    }
+
     Castling() = default;
 
     constexpr void set_00(Color c) { data |= (c == Color::WHITE ? 1 : 4); }
@@ -6,6 +6,7 @@
 
 #include "../utils/small_vector.h"
 #include "bitboard.h"
+#include "piece.h"
 
 namespace sonic {
 
@@ -19,22 +20,57 @@ class Move {
         Knight
     };
 
+    // Move types stored in the top 4 bits. Bit 3 marks promotions, bit 2 captures, and the low two
+    // bits of a promotion select the piece: knight, bishop, rook, queen.
+    enum Flag : std::uint8_t {
+        QUIET             = 0,
+        DOUBLE_PUSH       = 1,
+        KING_CASTLE       = 2,
+        QUEEN_CASTLE      = 3,
+        CAPTURE           = 4,
+        EN_PASSANT        = 5,
+        PROMOTION         = 8,
+        PROMOTION_CAPTURE = 12
+    };
+
     constexpr Move() = default;
     constexpr explicit Move(std::uint16_t num) :
         data(num) {}
-    constexpr Move(Square from, Square to) :
-        data(from.to_int() | (to.to_int() << 6)) {}
+    constexpr Move(Square from, Square to, std::uint8_t flags = QUIET) :
+        data(from.to_int() | (to.to_int() << 6) | (flags << 12)) {}
+    // Promotion without the capture flag, e.g. a move parsed from UCI before it is matched against
+    // the legal moves.
     constexpr Move(Square from, Square to, Promotion promotion) :
-        data(from.to_int() | (to.to_int() << 6) | (static_cast<std::uint8_t>(promotion) << 12)) {}
+        Move(from, to, promotion_flags(promotion, false)) {}
+
+    Square       from() const { return Square(data & kFromMask); }
+    Square       to() const { return Square((data & kToMask) >> 6); }
+    std::uint8_t flags() const { return data >> 12; }
+
+    // Move types, read from the flags only.
+    bool is_capture() const { return flags() & CAPTURE; }
+    bool is_promotion() const { return flags() & PROMOTION; }
+    bool is_quiet() const { return !(flags() & (CAPTURE | PROMOTION)); }
+    bool is_en_passant() const { return flags() == EN_PASSANT; }
+    bool is_double_push() const { return flags() == DOUBLE_PUSH; }
+    bool is_castling() const { return (flags() & ~1) == KING_CASTLE; }
 
-    Square    from() const { return Square(data & kFromMask); }
-    Square    to() const { return Square((data & kToMask) >> 6); }
-    Promotion promotion() const { return Promotion((data & kPromotionMask) >> 12); }
+    // Piece type a promotion promotes to.
+    PieceType promotion_type() const { return PieceType(PieceType::KNIGHT + (flags() & 3)); }
 
-    void set_from(Square from) { data = (data & ~kFromMask) | from.to_int(); }
-    void set_to(Square to) { data = (data & ~kToMask) | (to.to_int() << 6); }
-    void set_promotion(Promotion promotion) {
-        data = (data & ~kPromotionMask) | (static_cast<std::uint8_t>(promotion) << 12);
+    Promotion promotion() const {
+        constexpr Promotion Promotions[4] = {
+            Promotion::Knight, Promotion::Bishop, Promotion::Rook, Promotion::Queen};
+        return is_promotion() ? Promotions[flags() & 3] : Promotion::None;
+    }
+
+    // Flags of a promotion to `promotion`.
+    static constexpr std::uint8_t promotion_flags(Promotion promotion, bool capture) {
+        constexpr std::uint8_t Codes[5] = {0, 3, 2, 1, 0};
+        if (promotion == Promotion::None) {
+            return capture ? CAPTURE : QUIET;
+        }
+        return (capture ? PROMOTION_CAPTURE : PROMOTION) | Codes[static_cast<int>(promotion)];
     }
 
     std::uint16_t to_int() const { return data; }
@@ -67,14 +103,12 @@ class Move {
    private:
     // bits 0~5 -> from
     // bits 6~11 -> to
-    // bits 12~14 -> promotion
-    // Null move if all bits are set to 1.
+    // bits 12~15 -> flags
     std::uint16_t data = 0;
 
     enum Masks : std::uint16_t {
-        kFromMask      = 0b0000000000111111,
-        kToMask        = 0b0000111111000000,
-        kPromotionMask = 0b0111000000000000,
+        kFromMask = 0b0000000000111111,
+        kToMask   = 0b0000111111000000,
     };
 };
 
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 
+#include "attackinfo.h"
 #include "attacks.h"
 #include "bitboard.h"
 #include "castling.h"
@@ -12,263 +13,311 @@
 
 namespace sonic {
 
+namespace {
+
+// Destinations allowed for the non-king moves of a node.
+struct MoveTarget {
+    Square   king;
+    Bitboard target; // Squares resolving the check, or all squares when not in check.
+    Bitboard pinned;
+    Square   enemy_king;  // Only set for quiet checks.
+    Bitboard discoverers; // Only set for quiet checks.
+
+    // Destinations of the piece on `from`: pinned pieces stay on the line through the king.
+    Bitboard allowed(Square from) const {
+        return pinned.get(from) ? target & line_bb[king.to_int()][from.to_int()] : target;
+    }
+
+    // Destinations of the piece on `from` giving check, where `checks` are the squares its piece
+    // type checks the enemy king from. Discoverers check anywhere off their line to the king.
+    Bitboard checking(Square from, Bitboard checks) const {
+        if (!discoverers.get(from)) {
+            return checks;
+        }
+        return checks | Bitboard(~line_bb[enemy_king.to_int()][from.to_int()].to_int());
+    }
+};
+
+// Adds the moves from `from` to `targets` of generation type `Type`, flagging the captures of
+// `enemies`.
 template<GenType Type>
-void generate_pawn_moves(const Position& pos, MoveList& movelist) {
-    const Color&     us             = pos.side_to_move();
-    const Bitboard&  other_pieces   = pos.pieces(other_color(us));
-    const Rank&      initial_rank   = (us == Color::WHITE ? Rank::RANK_2 : Rank::RANK_7);
-    const Rank&      promotion_rank = (us == Color::WHITE ? Rank::RANK_7 : Rank::RANK_2);
-    const Direction& pawn_direction = (us == Color::WHITE ? Direction::NORTH : Direction::SOUTH);
-    Bitboard         pawns          = pos.pieces(us, PieceType::PAWN);
-    for (Square pawn : pawns) {
-        if (pawn.rank() != promotion_rank) {
-            if constexpr (Type != GenType::CAPTURE) {
-                Square one_step = pawn + pawn_direction;
-                if (pos.piece_on(one_step) == Piece::NO_PIECE) {
-                    movelist.emplace_back(pawn, one_step);
-                    // Check two steps
-                    if (pawn.rank() == initial_rank) {
-                        Square two_step = one_step + pawn_direction;
-                        if (pos.piece_on(two_step) == Piece::NO_PIECE) {
-                            movelist.emplace_back(pawn, two_step);
-                        }
-                    }
-                }
-            }
-            if constexpr (Type != GenType::NON_CAPTURE) {
-                for (Square to : pawn_attacks[us][pawn.to_int()]) {
-                    if (other_pieces.get(to) || to == pos.en_passant()) {
-                        movelist.emplace_back(pawn, to);
-                    }
-                }
-            }
-        } else {
-            // Check promotion
-            if constexpr (Type != GenType::CAPTURE) {
-                Square one_step = pawn + pawn_direction;
-                if (pos.piece_on(one_step) == Piece::NO_PIECE) {
-                    for (Move::Promotion promo : {Move::Promotion::Queen, Move::Promotion::Knight,
-                                                  Move::Promotion::Rook, Move::Promotion::Bishop}) {
-                        movelist.emplace_back(pawn, one_step, promo);
-                    }
-                }
+void add_moves(Square from, Bitboard targets, Bitboard enemies, MoveList& movelist) {
+    if constexpr (Type != GenType::NON_CAPTURE && Type != GenType::QUIET_CHECKS) {
+        for (Square to : targets & enemies) {
+            movelist.emplace_back(from, to, Move::CAPTURE);
+        }
+    }
+    if constexpr (Type != GenType::CAPTURE) {
+        for (Square to : targets - enemies) {
+            movelist.emplace_back(from, to);
+        }
+    }
+}
+
+// En passant removes two pieces from their squares, so it is checked on the resulting occupancy.
+bool legal_en_passant(const Position& pos, Square from, Square to) {
+    Color    us       = pos.side_to_move();
+    Square   captured = Square(to.file(), from.rank());
+    Bitboard occupied = (pos.pieces() - from - captured) + to;
+    return (pos.attackers_to(pos.king_square(us), other_color(us), occupied) - captured).empty();
+}
+
+// Adds the moves to `targets` of the pawns one `D` step behind them.
+template<Direction D>
+void add_pawn_moves(Bitboard          targets,
+                    const MoveTarget& mt,
+                    std::uint8_t      flags,
+                    MoveList&         movelist) {
+    for (Square to : targets) {
+        Square from = Square(std::uint8_t(to.to_int() - D));
+        if (mt.allowed(from).get(to)) {
+            movelist.emplace_back(from, to, flags);
+        }
+    }
+}
+
+// Adds the promotions to `targets` of the pawns one `D` step behind them.
+template<Direction D>
+void add_promotions(Bitboard targets, const MoveTarget& mt, bool capture, MoveList& movelist) {
+    for (Square to : targets) {
+        Square from = Square(std::uint8_t(to.to_int() - D));
+        if (mt.allowed(from).get(to)) {
+            for (Move::Promotion promo : {Move::Promotion::Queen, Move::Promotion::Knight,
+                                          Move::Promotion::Rook, Move::Promotion::Bishop}) {
+                movelist.emplace_back(from, to, Move::promotion_flags(promo, capture));
             }
-            if constexpr (Type != GenType::NON_CAPTURE) {
-                for (Square to : pawn_attacks[us][pawn.to_int()]) {
-                    if (other_pieces.get(to)) {
-                        for (Move::Promotion promo :
-                             {Move::Promotion::Queen, Move::Promotion::Knight,
-                              Move::Promotion::Rook, Move::Promotion::Bishop}) {
-                            movelist.emplace_back(pawn, to, promo);
-                        }
-                    }
+        }
+    }
+}
+
+} // namespace
+
+// Generates the moves of all pawns at once with bitboard shifts.
+template<Color Us, GenType Type>
+void generate_pawn_moves(const Position& pos, const MoveTarget& mt, MoveList& movelist) {
+    constexpr Color     Them      = other_color(Us);
+    constexpr Direction Up        = (Us == Color::WHITE ? Direction::NORTH : Direction::SOUTH);
+    constexpr Direction UpEast    = Up + Direction::EAST;
+    constexpr Direction UpWest    = Up + Direction::WEST;
+    constexpr Bitboard  Rank3BB   = rank_bb(Us == Color::WHITE ? Rank::RANK_3 : Rank::RANK_6);
+    constexpr Bitboard  Rank7BB   = rank_bb(Us == Color::WHITE ? Rank::RANK_7 : Rank::RANK_2);
+    const Bitboard      empty     = Bitboard(~pos.pieces().to_int());
+    const Bitboard      enemies   = pos.pieces(Them) & mt.target;
+    const Bitboard      pawns     = pos.pieces(Us, PieceType::PAWN) - Rank7BB;
+    const Bitboard      promoting = pos.pieces(Us, PieceType::PAWN) & Rank7BB;
+
+    if constexpr (Type != GenType::CAPTURE) {
+        Bitboard single_push = shift<Up>(pawns) & empty;
+        Bitboard double_push = shift<Up>(single_push & Rank3BB) & empty & mt.target;
+        if constexpr (Type == GenType::QUIET_CHECKS) {
+            // Pushes of discoverers check unless they stay on the file of the king.
+            Bitboard checks = pawn_attacks[Them][mt.enemy_king.to_int()];
+            Bitboard dc     = (pawns & mt.discoverers) - file_bb(mt.enemy_king.file());
+            single_push &= checks | shift<Up>(dc);
+            double_push &= checks | shift<Up>(shift<Up>(dc));
+        }
+        add_pawn_moves<Up>(single_push & mt.target, mt, Move::QUIET, movelist);
+        add_pawn_moves<Up + Up>(double_push, mt, Move::DOUBLE_PUSH, movelist);
+        if constexpr (Type != GenType::QUIET_CHECKS) {
+            add_promotions<Up>(shift<Up>(promoting) & empty & mt.target, mt, false, movelist);
+        }
+    }
+    if constexpr (Type != GenType::NON_CAPTURE && Type != GenType::QUIET_CHECKS) {
+        add_pawn_moves<UpWest>(shift<UpWest>(pawns) & enemies, mt, Move::CAPTURE, movelist);
+        add_pawn_moves<UpEast>(shift<UpEast>(pawns) & enemies, mt, Move::CAPTURE, movelist);
+        add_promotions<UpWest>(shift<UpWest>(promoting) & enemies, mt, true, movelist);
+        add_promotions<UpEast>(shift<UpEast>(promoting) & enemies, mt, true, movelist);
+
+        Square ep = pos.en_passant();
+        if (ep != SQ_NONE) {
+            for (Square from : pawns & pawn_attacks[Them][ep.to_int()]) {
+                if (legal_en_passant(pos, from, ep)) {
+                    movelist.emplace_back(from, ep, Move::EN_PASSANT);
                 }
             }
         }
     }
 }
 
-template<GenType Type>
-void generate_knight_moves(const Position& pos, MoveList& movelist) {
-    const Bitboard& my_pieces    = pos.pieces(pos.side_to_move());
-    const Bitboard& other_pieces = pos.pieces(other_color(pos.side_to_move()));
-    Bitboard        knights      = pos.pieces(pos.side_to_move(), PieceType::KNIGHT);
+template<Color Us, GenType Type>
+void generate_knight_moves(const Position& pos, const MoveTarget& mt, MoveList& movelist) {
+    constexpr Color Them         = other_color(Us);
+    const Bitboard& my_pieces    = pos.pieces(Us);
+    const Bitboard& other_pieces = pos.pieces(Them);
+    Bitboard        knights      = pos.pieces(Us, PieceType::KNIGHT);
     for (Square knight : knights) {
-        Bitboard attacks = knight_attacks[knight.to_int()] - my_pieces;
-        if constexpr (Type != GenType::ALL) {
-            if constexpr (Type == GenType::CAPTURE) {
-                attacks &= other_pieces;
-            }
-            if constexpr (Type == GenType::NON_CAPTURE) {
-                attacks -= other_pieces;
-            }
-        }
-        for (Square to : attacks) {
-            movelist.emplace_back(knight, to);
+        Bitboard attacks = (knight_attacks[knight.to_int()] - my_pieces) & mt.allowed(knight);
+        if constexpr (Type == GenType::QUIET_CHECKS) {
+            attacks &= mt.checking(knight, knight_attacks[mt.enemy_king.to_int()]);
         }
+        add_moves<Type>(knight, attacks, other_pieces, movelist);
     }
 }
 
-template<GenType Type>
-void generate_bishop_moves(const Position& pos, MoveList& movelist) {
-    const Bitboard& my_pieces    = pos.pieces(pos.side_to_move());
-    const Bitboard& other_pieces = pos.pieces(other_color(pos.side_to_move()));
+template<Color Us, GenType Type>
+void generate_bishop_moves(const Position& pos, const MoveTarget& mt, MoveList& movelist) {
+    constexpr Color Them         = other_color(Us);
+    const Bitboard& my_pieces    = pos.pieces(Us);
+    const Bitboard& other_pieces = pos.pieces(Them);
     const Bitboard& all_pieces   = my_pieces | other_pieces;
-    Bitboard        bishops      = pos.pieces(pos.side_to_move(), PieceType::BISHOP);
+    Bitboard        bishops      = pos.pieces(Us, PieceType::BISHOP);
     for (Square bishop : bishops) {
-        Bitboard attacks = bishop_magics[bishop.to_int()](all_pieces);
+        Bitboard attacks = bishop_attacks(bishop, all_pieces) & mt.allowed(bishop);
         attacks -= my_pieces;
-        if constexpr (Type != GenType::ALL) {
-            if constexpr (Type == GenType::CAPTURE) {
-                attacks &= other_pieces;
-            }
-            if constexpr (Type == GenType::NON_CAPTURE) {
-                attacks -= other_pieces;
-            }
-        }
-        for (Square to : attacks) {
-            movelist.emplace_back(bishop, to);
+        if constexpr (Type == GenType::QUIET_CHECKS) {
+            attacks &= mt.checking(bishop, bishop_attacks(mt.enemy_king, all_pieces));
         }
+        add_moves<Type>(bishop, attacks, other_pieces, movelist);
     }
 }
 
-template<GenType Type>
-void generate_rook_moves(const Position& pos, MoveList& movelist) {
-    const Bitboard& my_pieces    = pos.pieces(pos.side_to_move());
-    const Bitboard& other_pieces = pos.pieces(other_color(pos.side_to_move()));
+template<Color Us, GenType Type>
+void generate_rook_moves(const Position& pos, const MoveTarget& mt, MoveList& movelist) {
+    constexpr Color Them         = other_color(Us);
+    const Bitboard& my_pieces    = pos.pieces(Us);
+    const Bitboard& other_pieces = pos.pieces(Them);
     const Bitboard& all_pieces   = my_pieces | other_pieces;
-    Bitboard        rooks        = pos.pieces(pos.side_to_move(), PieceType::ROOK);
+    Bitboard        rooks        = pos.pieces(Us, PieceType::ROOK);
     for (Square rook : rooks) {
-        Bitboard attacks = rook_magics[rook.to_int()](all_pieces);
+        Bitboard attacks = rook_attacks(rook, all_pieces) & mt.allowed(rook);
         attacks -= my_pieces;
-        if constexpr (Type != GenType::ALL) {
-            if constexpr (Type == GenType::CAPTURE) {
-                attacks &= other_pieces;
-            }
-            if constexpr (Type == GenType::NON_CAPTURE) {
-                attacks -= other_pieces;
-            }
-        }
-        for (Square to : attacks) {
-            movelist.emplace_back(rook, to);
+        if constexpr (Type == GenType::QUIET_CHECKS) {
+            attacks &= mt.checking(rook, rook_attacks(mt.enemy_king, all_pieces));
         }
+        add_moves<Type>(rook, attacks, other_pieces, movelist);
     }
 }
 
-template<GenType Type>
-void generate_queen_moves(const Position& pos, MoveList& movelist) {
-    const Bitboard& my_pieces    = pos.pieces(pos.side_to_move());
-    const Bitboard& other_pieces = pos.pieces(other_color(pos.side_to_move()));
+template<Color Us, GenType Type>
+void generate_queen_moves(const Position& pos, const MoveTarget& mt, MoveList& movelist) {
+    constexpr Color Them         = other_color(Us);
+    const Bitboard& my_pieces    = pos.pieces(Us);
+    const Bitboard& other_pieces = pos.pieces(Them);
     const Bitboard& all_pieces   = my_pieces | other_pieces;
-    Bitboard        queens       = pos.pieces(pos.side_to_move(), PieceType::QUEEN);
+    Bitboard        queens       = pos.pieces(Us, PieceType::QUEEN);
     for (Square queen : queens) {
-        Bitboard attacks =
-            (rook_magics[queen.to_int()](all_pieces) | bishop_magics[queen.to_int()](all_pieces));
+        Bitboard attacks = queen_attacks(queen, all_pieces) & mt.allowed(queen);
         attacks -= my_pieces;
-        if constexpr (Type != GenType::ALL) {
-            if constexpr (Type == GenType::CAPTURE) {
-                attacks &= other_pieces;
-            }
-            if constexpr (Type == GenType::NON_CAPTURE) {
-                attacks -= other_pieces;
-            }
-        }
-        for (Square to : attacks) {
-            movelist.emplace_back(queen, to);
+        if constexpr (Type == GenType::QUIET_CHECKS) {
+            attacks &= mt.checking(queen, queen_attacks(mt.enemy_king, all_pieces));
         }
+        add_moves<Type>(queen, attacks, other_pieces, movelist);
     }
 }
 
-template<GenType Type>
-void generate_king_moves(const Position& pos, MoveList& movelist) {
-    const Bitboard& my_pieces    = pos.pieces(pos.side_to_move());
-    const Bitboard& other_pieces = pos.pieces(other_color(pos.side_to_move()));
-    Square          king         = pos.king_square(pos.side_to_move());
-    Bitboard        attacks      = king_attacks[king.to_int()] - my_pieces;
-    if constexpr (Type != GenType::ALL) {
-        if constexpr (Type == GenType::CAPTURE) {
-            attacks &= other_pieces;
-        }
-        if constexpr (Type == GenType::NON_CAPTURE) {
-            attacks -= other_pieces;
+template<Color Us, GenType Type>
+void generate_king_moves(const Position& pos, AttackInfo& ai, MoveList& movelist) {
+    constexpr Color Them         = other_color(Us);
+    const Bitboard& my_pieces    = pos.pieces(Us);
+    const Bitboard& other_pieces = pos.pieces(Them);
+    Square          king         = pos.king_square(Us);
+    if constexpr (Type == GenType::QUIET_CHECKS) {
+        // The king only checks by discovery and it never castles into check here.
+        if (!ai.discoverers().get(king)) {
+            return;
         }
     }
-    for (Square to : attacks) {
-        movelist.emplace_back(king, to);
+    Bitboard attacks = king_attacks[king.to_int()] - my_pieces - ai.king_danger();
+    if constexpr (Type == GenType::QUIET_CHECKS) {
+        attacks -= line_bb[pos.king_square(Them).to_int()][king.to_int()];
     }
+    add_moves<Type>(king, attacks, other_pieces, movelist);
 
     // Check castlings
-    if constexpr (Type == GenType::CAPTURE) {
+    if constexpr (Type == GenType::CAPTURE || Type == GenType::QUIET_CHECKS) {
         return;
     }
-    if (pos.side_to_move() == Color::WHITE) {
-        // White short castle
-        if (pos.castling_rights().white_can_00()) {
-            bool invalid = false;
-            for (Square sq : Castling::WHITE_00_PATH_BB) {
-                if (pos.attacks_by(sq, Color::BLACK)) {
-                    invalid = true;
-                    break;
-                }
-                if (sq != king && pos.piece_on(sq) != Piece::NO_PIECE) {
-                    invalid = true;
-                    break;
-                }
-            }
-            if (!invalid) {
-                movelist.push_back(Castling::WHITE_00_MOVE);
-            }
+    if (!pos.castling_rights().any(Us) || ai.in_check()) {
+        return;
+    }
+    constexpr bool     White  = (Us == Color::WHITE);
+    constexpr Square   KingSq = (White ? SQ_E1 : SQ_E8);
+    constexpr Bitboard ShortPath =
+        (White ? Castling::WHITE_00_PATH_BB : Castling::BLACK_00_PATH_BB);
+    constexpr Bitboard LongPath =
+        (White ? Castling::WHITE_000_PATH_BB : Castling::BLACK_000_PATH_BB);
+    constexpr Square LongExtra =
+        (White ? Castling::WHITE_000_EXTRA_SQ : Castling::BLACK_000_EXTRA_SQ);
+    const Bitboard& occupied = my_pieces | other_pieces;
+    // Short castle
+    if (pos.castling_rights().can_00(Us)) {
+        if (((ShortPath - KingSq) & occupied).empty() && (ShortPath & ai.king_danger()).empty()) {
+            movelist.push_back(White ? Castling::WHITE_00_MOVE : Castling::BLACK_00_MOVE);
         }
+    }
 
-        // White long castle
-        if (pos.castling_rights().white_can_000()) {
-            bool invalid = (pos.piece_on(Castling::WHITE_000_EXTRA_SQ) != Piece::NO_PIECE);
-            for (Square sq : Castling::WHITE_000_PATH_BB) {
-                if (pos.attacks_by(sq, Color::BLACK)) {
-                    invalid = true;
-                    break;
-                }
-                if (sq != king && pos.piece_on(sq) != Piece::NO_PIECE) {
-                    invalid = true;
-                    break;
-                }
-            }
-            if (!invalid) {
-                movelist.push_back(Castling::WHITE_000_MOVE);
-            }
-        }
-    } else {
-        // Black short castle
-        if (pos.castling_rights().black_can_00()) {
-            bool invalid = false;
-            for (Square sq : Castling::BLACK_00_PATH_BB) {
-                if (pos.attacks_by(sq, Color::WHITE)) {
-                    invalid = true;
-                    break;
-                }
-                if (sq != king && pos.piece_on(sq) != Piece::NO_PIECE) {
-                    invalid = true;
-                    break;
-                }
-            }
-            if (!invalid) {
-                movelist.push_back(Castling::BLACK_00_MOVE);
-            }
+    // Long castle
+    if (pos.castling_rights().can_000(Us)) {
+        if ((((LongPath - KingSq) + LongExtra) & occupied).empty()
+            && (LongPath & ai.king_danger()).empty()) {
+            movelist.push_back(White ? Castling::WHITE_000_MOVE : Castling::BLACK_000_MOVE);
         }
+    }
+}
 
-        // Black long castle
-        if (pos.castling_rights().black_can_000()) {
-            bool invalid = (pos.piece_on(Castling::BLACK_000_EXTRA_SQ) != Piece::NO_PIECE);
-            for (Square sq : Castling::BLACK_000_PATH_BB) {
-                if (pos.attacks_by(sq, Color::WHITE)) {
-                    invalid = true;
-                    break;
-                }
-                if (sq != king && pos.piece_on(sq) != Piece::NO_PIECE) {
-                    invalid = true;
-                    break;
-                }
-            }
-            if (!invalid) {
-                movelist.push_back(Castling::BLACK_000_MOVE);
-            }
+// Generates legal moves for the side to move `Us`.
+template<Color Us, GenType Type>
+void generate_moves(const Position& pos, AttackInfo& ai, MoveList& movelist) {
+    Bitboard checkers = ai.checkers();
+    // Only the king can move out of a double check.
+    if (checkers.count() < 2) {
+        MoveTarget mt{pos.king_square(Us), Bitboard(~std::uint64_t(0)), ai.pinned()};
+        if (checkers.any()) {
+            Square checker = Square(lsb(checkers.to_int()));
+            mt.target      = between_bb[mt.king.to_int()][checker.to_int()] + checker;
+        }
+        if constexpr (Type == GenType::QUIET_CHECKS) {
+            mt.enemy_king  = pos.king_square(other_color(Us));
+            mt.discoverers = ai.discoverers();
         }
+        generate_pawn_moves<Us, Type>(pos, mt, movelist);
+        generate_knight_moves<Us, Type>(pos, mt, movelist);
+        generate_bishop_moves<Us, Type>(pos, mt, movelist);
+        generate_rook_moves<Us, Type>(pos, mt, movelist);
+        generate_queen_moves<Us, Type>(pos, mt, movelist);
+    }
+    generate_king_moves<Us, Type>(pos, ai, movelist);
+}
+
+// Generates legal moves.
+template<GenType Type>
+void generate_moves(const Position& pos, AttackInfo& ai, MoveList& movelist) {
+    if (pos.side_to_move() == Color::WHITE) {
+        generate_moves<Color::WHITE, Type>(pos, ai, movelist);
+    } else {
+        generate_moves<Color::BLACK, Type>(pos, ai, movelist);
     }
 }
 
-// Generates pseudo legal moves.
 template<GenType Type>
 void generate_moves(const Position& pos, MoveList& movelist) {
-    generate_pawn_moves<Type>(pos, movelist);
-    generate_knight_moves<Type>(pos, movelist);
-    generate_bishop_moves<Type>(pos, movelist);
-    generate_rook_moves<Type>(pos, movelist);
-    generate_queen_moves<Type>(pos, movelist);
-    generate_king_moves<Type>(pos, movelist);
+    AttackInfo ai(pos);
+    generate_moves<Type>(pos, ai, movelist);
+}
+
+Move find_legal_move(const Position& pos, Move m) {
+    MoveList movelist;
+    generate_moves<GenType::LEGAL>(pos, movelist);
+    for (Move legal : movelist) {
+        if (legal.from() == m.from() && legal.to() == m.to()
+            && legal.promotion() == m.promotion()) {
+            return legal;
+        }
+    }
+    return MOVE_NONE;
 }
 
+// clang-format off
+template void generate_moves<GenType::CAPTURE>(const Position& pos, AttackInfo& ai, MoveList& movelist);
+template void generate_moves<GenType::NON_CAPTURE>(const Position& pos, AttackInfo& ai, MoveList& movelist);
+template void generate_moves<GenType::LEGAL>(const Position& pos, AttackInfo& ai, MoveList& movelist);
+template void generate_moves<GenType::EVASIONS>(const Position& pos, AttackInfo& ai, MoveList& movelist);
+template void generate_moves<GenType::QUIET_CHECKS>(const Position& pos, AttackInfo& ai, MoveList& movelist);
 template void generate_moves<GenType::CAPTURE>(const Position& pos, MoveList& movelist);
 template void generate_moves<GenType::NON_CAPTURE>(const Position& pos, MoveList& movelist);
-template void generate_moves<GenType::ALL>(const Position& pos, MoveList& movelist);
+template void generate_moves<GenType::LEGAL>(const Position& pos, MoveList& movelist);
+template void generate_moves<GenType::EVASIONS>(const Position& pos, MoveList& movelist);
+template void generate_moves<GenType::QUIET_CHECKS>(const Position& pos, MoveList& movelist);
+// clang-format on
 
 } // namespace sonic
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "attackinfo.h"
 #include "move.h"
 #include "position.h"
 
@@ -8,17 +9,21 @@ namespace sonic {
 enum GenType {
     CAPTURE,
     NON_CAPTURE,
-    ALL
+    LEGAL,
+    EVASIONS,     // All legal moves when in check.
+    QUIET_CHECKS  // Non-capturing moves giving a direct or discovered check, when not in check.
 };
 
-// Generates pseudo legal moves.
-// template<GenType Type> void generate_pawn_moves(const Position& pos, MoveList& movelist);
-// template<GenType Type> void generate_knight_moves(const Position& pos, MoveList& movelist);
-// template<GenType Type> void generate_bishop_moves(const Position& pos, MoveList& movelist);
-// template<GenType Type> void generate_rook_moves(const Position& pos, MoveList& movelist);
-// template<GenType Type> void generate_queen_moves(const Position& pos, MoveList& movelist);
-// template<GenType Type> void generate_king_moves(const Position& pos, MoveList& movelist);
+// Generates legal moves. Checkers and pinned pieces are taken from `ai`: in check only evasions
+// are generated, pinned pieces stay on their pin rays and king moves avoid the attacked squares.
+// Quiet checks exclude promotions and castling.
+template<GenType Type>
+void generate_moves(const Position& pos, AttackInfo& ai, MoveList& movelist);
 template<GenType Type>
 void generate_moves(const Position& pos, MoveList& movelist);
 
+// Returns the legal move with the squares and promotion of `m`, whose flags may be missing (e.g. a
+// move read from UCI or a book), or MOVE_NONE if there is none.
+Move find_legal_move(const Position& pos, Move m);
+
 } // namespace sonic
\ No newline at end of file
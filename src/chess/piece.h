@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 
 #include "color.h"
 
@@ -17,7 +18,7 @@ enum PieceType {
     NO_PIECE_TYPE = 7
 };
 
-enum Piece {
+enum Piece : std::uint8_t {
     W_PAWN   = 0,
     W_KNIGHT = 1,
     W_BISHOP = 2,
@@ -42,6 +43,8 @@ constexpr Color color(Piece p) {
 
 constexpr PieceType type(Piece p) { return PieceType(p & 7); }
 
+constexpr Piece make_piece(Color c, PieceType pt) { return Piece(c * 8 + pt); }
+
 constexpr char to_char(Piece p) {
     switch (p) {
     case Piece::W_PAWN :
@@ -18,12 +18,89 @@
 
 namespace sonic {
 
+namespace {
+
+// Cuckoo tables of the reversible piece moves, keyed by the zobrist key change of the move
+// (Marcel van Kervinck's method). Each move sits at one of its two hash slots.
+constexpr int CUCKOO_SIZE = 8192;
+
+constexpr int cuckoo_h1(std::uint64_t key) { return key & (CUCKOO_SIZE - 1); }
+constexpr int cuckoo_h2(std::uint64_t key) { return (key >> 16) & (CUCKOO_SIZE - 1); }
+
+struct CuckooTable {
+    std::uint64_t keys[CUCKOO_SIZE];
+    Move          moves[CUCKOO_SIZE];
+    int           count;
+};
+
+// Returns if a piece of type `pt` on `a` attacks `b` on an empty board.
+constexpr bool pseudo_attacks(PieceType pt, int a, int b) {
+    int df = a % 8 > b % 8 ? a % 8 - b % 8 : b % 8 - a % 8;
+    int dr = a / 8 > b / 8 ? a / 8 - b / 8 : b / 8 - a / 8;
+    switch (pt) {
+    case PieceType::KNIGHT :
+        return (df == 1 && dr == 2) || (df == 2 && dr == 1);
+    case PieceType::BISHOP :
+        return df == dr && df > 0;
+    case PieceType::ROOK :
+        return (df == 0) != (dr == 0);
+    case PieceType::QUEEN :
+        return pseudo_attacks(PieceType::BISHOP, a, b) || pseudo_attacks(PieceType::ROOK, a, b);
+    case PieceType::KING :
+        return df <= 1 && dr <= 1 && df + dr > 0;
+    default :
+        return false;
+    }
+}
+
+constexpr CuckooTable make_cuckoo() {
+    CuckooTable table{};
+    for (Piece p : {Piece::W_KNIGHT, Piece::W_BISHOP, Piece::W_ROOK, Piece::W_QUEEN, Piece::W_KING,
+                    Piece::B_KNIGHT, Piece::B_BISHOP, Piece::B_ROOK, Piece::B_QUEEN,
+                    Piece::B_KING}) {
+        for (int s1 = 0; s1 < Square::SQ_NB; s1++) {
+            for (int s2 = s1 + 1; s2 < Square::SQ_NB; s2++) {
+                if (!pseudo_attacks(type(p), s1, s2)) {
+                    continue;
+                }
+                Square        from = Square(std::uint8_t(s1));
+                Square        to   = Square(std::uint8_t(s2));
+                Move          move = Move(from, to);
+                std::uint64_t key  = zobrist_key(from, p) ^ zobrist_key(to, p)
+                                  ^ zobrist_key(Color::WHITE) ^ zobrist_key(Color::BLACK);
+                // Kick out the occupant of the slot and move it to its other slot until one is
+                // free.
+                int i = cuckoo_h1(key);
+                while (true) {
+                    std::uint64_t old_key  = table.keys[i];
+                    Move          old_move = table.moves[i];
+                    table.keys[i]          = key;
+                    table.moves[i]         = move;
+                    if (old_move == Move()) {
+                        break;
+                    }
+                    key  = old_key;
+                    move = old_move;
+                    i    = (i == cuckoo_h1(key) ? cuckoo_h2(key) : cuckoo_h1(key));
+                }
+                table.count++;
+            }
+        }
+    }
+    return table;
+}
+
+constexpr CuckooTable Cuckoo = make_cuckoo();
+static_assert(Cuckoo.count == 3668, "unexpected number of reversible moves");
+
+} // namespace
+
 void Position::set(std::string fen) {
     std::vector<std::string> tokens = split_string(fen, ' ');
     assert(tokens.size() == 6);
     key = 0;
-    history_keys.fill(0);
-    history_count = 0;
+    history.clear();
+    history.reserve(MAX_MOVES);
 
     // 1. Piece placement
     clear_board();
@@ -105,8 +182,9 @@ void Position::set(std::string fen) {
     key ^= (has_en_passant_capture() * zobrist_key(enPassant));
 
     // 5-6. ply
-    rule50  = std::stoi(tokens[4]);
-    gamePly = std::max(2 * std::stoi(tokens[5]) - 2, 0) + (sideToMove == Color::BLACK);
+    rule50        = std::stoi(tokens[4]);
+    pliesFromNull = 0;
+    gamePly       = std::max(2 * std::stoi(tokens[5]) - 2, 0) + (sideToMove == Color::BLACK);
 }
 
 // Returns the FEN representation of the position as a string.
@@ -154,14 +232,12 @@ bool Position::attacks_by(Square sq, Color c) const {
     const Bitboard& all_pieces = c_pieces | pieces(other_color(c));
     // Check rook + queen attacks
     const Bitboard& c_rook_and_queen = pieces(c, PieceType::ROOK) | pieces(c, PieceType::QUEEN);
-    const Bitboard& rook_attacks     = rook_magics[sq.to_int()](all_pieces);
-    if ((rook_attacks & c_rook_and_queen).any()) {
+    if ((rook_attacks(sq, all_pieces) & c_rook_and_queen).any()) {
         return true;
     }
     // Check bishop + queen attacks
     const Bitboard& c_bishop_and_queen = pieces(c, PieceType::BISHOP) | pieces(c, PieceType::QUEEN);
-    const Bitboard& bishop_attacks     = bishop_magics[sq.to_int()](all_pieces);
-    if ((bishop_attacks & c_bishop_and_queen).any()) {
+    if ((bishop_attacks(sq, all_pieces) & c_bishop_and_queen).any()) {
         return true;
     }
     // Check pawn attacks
@@ -177,33 +253,60 @@ bool Position::attacks_by(Square sq, Color c) const {
     return false;
 }
 
-// Apply a move on the board and returns true if the given move is legal.
-bool Position::make_move(Move m, UndoInfo& info) {
+// Returns the pieces of `c` attacking `sq`, with sliders blocked by `occupied`.
+Bitboard Position::attackers_to(Square sq, Color c, Bitboard occupied) const {
+    Bitboard rooks   = pieces(c, PieceType::ROOK) | pieces(c, PieceType::QUEEN);
+    Bitboard bishops = pieces(c, PieceType::BISHOP) | pieces(c, PieceType::QUEEN);
+    return (knight_attacks[sq.to_int()] & pieces(c, PieceType::KNIGHT))
+         | (rook_attacks(sq, occupied) & rooks)
+         | (bishop_attacks(sq, occupied) & bishops)
+         | (pawn_attacks[other_color(c)][sq.to_int()] & pieces(c, PieceType::PAWN))
+         | (king_attacks[sq.to_int()] & pieces(c, PieceType::KING));
+}
+
+// Apply a legal move on the board.
+void Position::make_move(Move m, UndoInfo& info) {
+    if (sideToMove == Color::WHITE) {
+        make_move<Color::WHITE>(m, info);
+    } else {
+        make_move<Color::BLACK>(m, info);
+    }
+}
+
+template<Color Us>
+void Position::make_move(Move m, UndoInfo& info) {
+    constexpr Color     Them      = other_color(Us);
+    constexpr Direction Down      = (Us == Color::WHITE ? Direction::SOUTH : Direction::NORTH);
+    constexpr Move      ShortRook = Castling::rook_00_move(Us);
+    constexpr Move      LongRook  = Castling::rook_000_move(Us);
+
+#if defined(USE_COPY_MAKE)
+    info.state = static_cast<const BoardState&>(*this);
+#else
+    // Only a normal capture leaves a piece on the target square.
     info.last_move      = m;
     info.rule50         = rule50;
-    info.history_count  = history_count;
     info.castling_state = castlings;
     info.en_passant     = enPassant;
-    info.captured_piece = Piece::NO_PIECE;
+    info.captured_piece = piece_on(m.to());
     info.key            = key;
+#endif
 
-    history_keys[history_count] = key;
-    history_count++;
+    history.push_back(key);
     gamePly++;
     rule50++;
-    key ^= zobrist_key(castlings) ^ zobrist_key(sideToMove)
-         ^ (has_en_passant_capture() * zobrist_key(enPassant));
+    pliesFromNull++;
+    key ^= zobrist_key(castlings) ^ zobrist_key(Us)
+         ^ (has_en_passant_capture(Us) * zobrist_key(enPassant));
 
-    Color us   = sideToMove;
-    Color them = other_color(sideToMove);
-    sideToMove = them;
+    sideToMove = Them;
 
     Square    from = m.from();
     Square    to   = m.to();
     Piece     p    = piece_on(from);
     PieceType pt   = type(p);
 
-    assert(to != king_square(them));
+    assert(to != king_square(Them));
 
     // Reset castlings when rook moves or rook was captured.
     if (from == SQ_H1 || to == SQ_H1) {
@@ -220,157 +323,133 @@ bool Position::make_move(Move m, UndoInfo& info) {
     }
 
     if (pt == PieceType::KING) {
-        castlings.reset_00(us);
-        castlings.reset_000(us);
-    }
-
-    if (piece_on(to) != Piece::NO_PIECE) {
-        // Reset rule50 when captures.
-        info.captured_piece = piece_on(to);
-        rule50              = 0;
-        history_count       = 0;
-        remove_piece(to);
+        castlings.reset_00(Us);
+        castlings.reset_000(Us);
     }
 
-    remove_piece(from);
-    add_piece(to, p);
-
+    enPassant = SQ_NONE;
     if (pt == PieceType::PAWN) {
-        rule50        = 0;
-        history_count = 0;
-
-        // Check if the move is an en passant capture.
-        if (to == enPassant) {
-            remove_piece(enPassant + (us == Color::WHITE ? Direction::SOUTH : Direction::NORTH));
-        }
-
-        // Update en passant square.
-        enPassant = SQ_NONE;
-        if (from.rank() == Rank::RANK_2 && to.rank() == Rank::RANK_4) {
-            enPassant = Square(from.file(), Rank::RANK_3);
-        }
-        if (from.rank() == Rank::RANK_7 && to.rank() == Rank::RANK_5) {
-            enPassant = Square(from.file(), Rank::RANK_6);
-        }
+        rule50 = 0;
+    }
 
-        // Handle promotion.
-        auto promotion = m.promotion();
-        if (promotion != Move::Promotion::None) {
+    switch (m.flags()) {
+    case Move::QUIET :
+        move_piece(from, to);
+        break;
+    case Move::DOUBLE_PUSH :
+        move_piece(from, to);
+        enPassant = to + Down;
+        break;
+    case Move::KING_CASTLE :
+    case Move::QUEEN_CASTLE : {
+        const Move& rook_move = (m.flags() == Move::KING_CASTLE ? ShortRook : LongRook);
+        move_piece(from, to);
+        move_piece(rook_move.from(), rook_move.to());
+        break;
+    }
+    case Move::EN_PASSANT :
+        remove_piece(to + Down);
+        move_piece(from, to);
+        break;
+    default :
+        if (m.is_capture()) {
+            // Reset rule50 when captures.
+            rule50 = 0;
             remove_piece(to);
-            Piece promotion_to = Piece::NO_PIECE;
-            switch (promotion) {
-            case Move::Promotion::Queen :
-                promotion_to = (us == Color::WHITE ? Piece::W_QUEEN : Piece::B_QUEEN);
-                break;
-            case Move::Promotion::Knight :
-                promotion_to = (us == Color::WHITE ? Piece::W_KNIGHT : Piece::B_KNIGHT);
-                break;
-            case Move::Promotion::Rook :
-                promotion_to = (us == Color::WHITE ? Piece::W_ROOK : Piece::B_ROOK);
-                break;
-            case Move::Promotion::Bishop :
-                promotion_to = (us == Color::WHITE ? Piece::W_BISHOP : Piece::B_BISHOP);
-                break;
-            default :
-                break;
-            }
-            add_piece(to, promotion_to);
         }
-    } else {
-        enPassant = SQ_NONE;
-    }
-
-    if (pt == PieceType::KING) {
-        // Check if the move is castling.
-        if (m == Castling::WHITE_00_MOVE) {
-            const Move& rook_move = Castling::WHITE_00_ROOK_MOVE;
-            remove_piece(rook_move.from());
-            add_piece(rook_move.to(), Piece::W_ROOK);
-        } else if (m == Castling::WHITE_000_MOVE) {
-            const Move& rook_move = Castling::WHITE_000_ROOK_MOVE;
-            remove_piece(rook_move.from());
-            add_piece(rook_move.to(), Piece::W_ROOK);
-        } else if (m == Castling::BLACK_00_MOVE) {
-            const Move& rook_move = Castling::BLACK_00_ROOK_MOVE;
-            remove_piece(rook_move.from());
-            add_piece(rook_move.to(), Piece::B_ROOK);
-        } else if (m == Castling::BLACK_000_MOVE) {
-            const Move& rook_move = Castling::BLACK_000_ROOK_MOVE;
-            remove_piece(rook_move.from());
-            add_piece(rook_move.to(), Piece::B_ROOK);
+        if (m.is_promotion()) {
+            remove_piece(from);
+            add_piece(to, make_piece(Us, m.promotion_type()));
+        } else {
+            move_piece(from, to);
         }
+        break;
     }
 
-    key ^= zobrist_key(castlings) ^ zobrist_key(sideToMove)
-         ^ (has_en_passant_capture() * zobrist_key(enPassant));
-
-    return !attacks_by(king_square(us), them);
+    key ^= zobrist_key(castlings) ^ zobrist_key(Them)
+         ^ (has_en_passant_capture(Them) * zobrist_key(enPassant));
 }
 
 void Position::unmake_move(const UndoInfo& info) {
-    Piece moved_piece = piece_on(info.last_move.to());
-    remove_piece(info.last_move.to());
-
-    // Check promotion.
-    if (info.last_move.promotion() != Move::Promotion::None) {
-        moved_piece = (sideToMove == Color::WHITE ? Piece::B_PAWN : Piece::W_PAWN);
-    }
-    add_piece(info.last_move.from(), moved_piece);
-
-    // Check captures.
-    if (info.captured_piece != Piece::NO_PIECE) {
-        add_piece(info.last_move.to(), info.captured_piece);
+#if defined(USE_COPY_MAKE)
+    static_cast<BoardState&>(*this) = info.state;
+    history.pop_back();
+#else
+    // The side that made the move is the opponent of the side to move.
+    if (sideToMove == Color::BLACK) {
+        unmake_move<Color::WHITE>(info);
+    } else {
+        unmake_move<Color::BLACK>(info);
     }
+#endif
+}
 
-    // Check en passant.
-    if (type(moved_piece) == PieceType::PAWN && info.last_move.to() == info.en_passant) {
-        Direction d = (sideToMove == Color::WHITE ? Direction::NORTH : Direction::SOUTH);
-        add_piece(info.last_move.to() + d,
-                  sideToMove == Color::WHITE ? Piece::W_PAWN : Piece::B_PAWN);
+#if !defined(USE_COPY_MAKE)
+template<Color Us>
+void Position::unmake_move(const UndoInfo& info) {
+    constexpr Direction Down      = (Us == Color::WHITE ? Direction::SOUTH : Direction::NORTH);
+    constexpr Move      ShortRook = Castling::rook_00_move(Us);
+    constexpr Move      LongRook  = Castling::rook_000_move(Us);
+
+    Move   m    = info.last_move;
+    Square from = m.from();
+    Square to   = m.to();
+    switch (m.flags()) {
+    case Move::QUIET :
+    case Move::DOUBLE_PUSH :
+        move_piece(to, from);
+        break;
+    case Move::KING_CASTLE :
+    case Move::QUEEN_CASTLE : {
+        const Move& rook_move = (m.flags() == Move::KING_CASTLE ? ShortRook : LongRook);
+        move_piece(to, from);
+        move_piece(rook_move.to(), rook_move.from());
+        break;
     }
-
-    // Check castling.
-    if (type(moved_piece) == PieceType::KING) {
-        if (info.last_move == Castling::WHITE_00_MOVE) {
-            const Move& rook_move = Castling::WHITE_00_ROOK_MOVE;
-            remove_piece(rook_move.to());
-            add_piece(rook_move.from(), Piece::W_ROOK);
-        } else if (info.last_move == Castling::WHITE_000_MOVE) {
-            const Move& rook_move = Castling::WHITE_000_ROOK_MOVE;
-            remove_piece(rook_move.to());
-            add_piece(rook_move.from(), Piece::W_ROOK);
-        } else if (info.last_move == Castling::BLACK_00_MOVE) {
-            const Move& rook_move = Castling::BLACK_00_ROOK_MOVE;
-            remove_piece(rook_move.to());
-            add_piece(rook_move.from(), Piece::B_ROOK);
-        } else if (info.last_move == Castling::BLACK_000_MOVE) {
-            const Move& rook_move = Castling::BLACK_000_ROOK_MOVE;
-            remove_piece(rook_move.to());
-            add_piece(rook_move.from(), Piece::B_ROOK);
+    case Move::EN_PASSANT :
+        move_piece(to, from);
+        add_piece(to + Down, make_piece(other_color(Us), PieceType::PAWN));
+        break;
+    default :
+        if (m.is_promotion()) {
+            remove_piece(to);
+            add_piece(from, make_piece(Us, PieceType::PAWN));
+        } else {
+            move_piece(to, from);
+        }
+        if (m.is_capture()) {
+            add_piece(to, info.captured_piece);
         }
+        break;
     }
 
     // Restore states.
-    castlings     = info.castling_state;
-    enPassant     = info.en_passant;
-    rule50        = info.rule50;
-    history_count = info.history_count;
-    key           = info.key;
+    castlings = info.castling_state;
+    enPassant = info.en_passant;
+    rule50    = info.rule50;
+    key       = info.key;
+    history.pop_back();
     gamePly--;
-    sideToMove = other_color(sideToMove);
+    pliesFromNull--;
+    sideToMove = Us;
 }
+#endif
 
 void Position::make_null_move(UndoInfo& info) {
-    info.last_move              = MOVE_NONE;
-    info.rule50                 = rule50;
-    info.history_count          = history_count;
-    info.castling_state         = castlings;
-    info.en_passant             = enPassant;
-    info.captured_piece         = Piece::NO_PIECE;
-    info.key                    = key;
-    history_keys[history_count] = key;
-    history_count++;
+#if defined(USE_COPY_MAKE)
+    info.state = static_cast<const BoardState&>(*this);
+#else
+    info.last_move       = MOVE_NONE;
+    info.rule50          = rule50;
+    info.plies_from_null = pliesFromNull;
+    info.castling_state  = castlings;
+    info.en_passant      = enPassant;
+    info.captured_piece  = Piece::NO_PIECE;
+    info.key             = key;
+#endif
+    history.push_back(key);
     rule50++;
+    pliesFromNull = 0;
     gamePly++;
 
     key ^= zobrist_key(sideToMove);
@@ -383,13 +462,60 @@ void Position::make_null_move(UndoInfo& info) {
 }
 
 void Position::unmake_null_move(const UndoInfo& info) {
+#if defined(USE_COPY_MAKE)
+    static_cast<BoardState&>(*this) = info.state;
+#else
     rule50        = info.rule50;
-    history_count = info.history_count;
+    pliesFromNull = info.plies_from_null;
     castlings     = info.castling_state;
     enPassant     = info.en_passant;
     key           = info.key;
     gamePly--;
     sideToMove = other_color(sideToMove);
+#endif
+    history.pop_back();
+}
+
+bool Position::has_game_cycle(int ply) const {
+    // A cycle through a null move is not reachable, as it skips a move of one side.
+    int size = int(history.size());
+    int end  = std::min({size, rule50, pliesFromNull});
+    if (end < 3) {
+        return false;
+    }
+    // The position after the move has the other side to move, so it is an odd number of plies
+    // back.
+    for (int i = 3; i <= end; i += 2) {
+        std::uint64_t move_key = key ^ history[size - i];
+        int           slot     = cuckoo_h1(move_key);
+        if (Cuckoo.keys[slot] != move_key) {
+            slot = cuckoo_h2(move_key);
+            if (Cuckoo.keys[slot] != move_key) {
+                continue;
+            }
+        }
+        Move   move = Cuckoo.moves[slot];
+        Square s1   = move.from();
+        Square s2   = move.to();
+        if ((between_bb[s1.to_int()][s2.to_int()] & pieces()).any()) {
+            continue;
+        }
+        if (ply > i) {
+            return true;
+        }
+        // The cycle reaches back to the root or beyond, where a single occurrence is not a draw.
+        // The table stores one direction of each move, so it must be the side to move's piece.
+        Piece p = piece_on(piece_on(s1) == Piece::NO_PIECE ? s2 : s1);
+        if (color(p) != sideToMove) {
+            continue;
+        }
+        for (int j = i + 4; j <= end; j += 2) {
+            if (history[size - j] == history[size - i]) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 // Visualize the current position.
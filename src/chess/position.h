@@ -1,9 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <vector>
 #include <string>
 
+#include "attacks.h"
 #include "bitboard.h"
 #include "castling.h"
 #include "color.h"
@@ -14,17 +16,48 @@
 
 namespace sonic {
 
+#if defined(USE_COPY_MAKE)
+constexpr bool use_copy_make = true;
+#else
+constexpr bool use_copy_make = false;
+#endif
+
+// The board state of a position. It is kept compact so that it spans few cache lines and copies
+// cheaply.
+struct BoardState {
+    Bitboard      byTypeBB[PieceType::PIECE_NB];
+    Bitboard      byColorBB[Color::COLOR_NB];
+    Bitboard      occupiedBB;
+    std::uint64_t key;
+    std::uint64_t materialKey;
+    Piece         board[Square::SQ_NB];
+    std::uint8_t  pieceCount[Color::COLOR_NB][PieceType::PIECE_NB];
+    Color         sideToMove;
+    Castling      castlings;
+    Square        enPassant;
+    int           rule50;
+    int           pliesFromNull; // Plies since the last null move or the root of the game.
+    int           gamePly;
+};
+
+#if defined(USE_COPY_MAKE)
+// Copy-make: the board state is saved before each move and copied back to undo it.
+struct UndoInfo {
+    BoardState state;
+};
+#else
 struct UndoInfo {
     Move          last_move;
     Castling      castling_state;
     Square        en_passant;
     Piece         captured_piece;
     int           rule50;
-    int           history_count;
+    int           plies_from_null;
     std::uint64_t key;
 };
+#endif
 
-class Position {
+class Position : private BoardState {
    public:
     Position() :
         Position(INITIAL_FEN) {}
@@ -38,6 +71,9 @@ class Position {
     // Returns the zobrist hash key of the current position.
     constexpr std::uint64_t hashkey() const { return key; }
 
+    // Returns the material signature key, which only depends on the piece counts.
+    constexpr std::uint64_t material_key() const { return materialKey; }
+
     constexpr Color    side_to_move() const { return sideToMove; }
     constexpr Square   en_passant() const { return enPassant; }
     constexpr int      game_ply() const { return gamePly; }
@@ -52,35 +88,29 @@ class Position {
 
     bool in_check() const { return attacks_by(king_square(sideToMove), other_color(sideToMove)); }
 
-    bool is_capture(Move m) const {
-        const Square& to = m.to();
-        return piece_on(to) != Piece::NO_PIECE || to == enPassant;
-    }
+    bool is_capture(Move m) const { return m.is_capture(); }
 
-    bool is_quiet(Move m) const { return !is_capture(m) && m.promotion() == Move::Promotion::None; }
+    bool is_quiet(Move m) const { return m.is_quiet(); }
 
-    bool has_en_passant_capture() const {
+    // Returns if a pawn of `c` attacks the en passant square.
+    bool has_en_passant_capture(Color c) const {
         if (enPassant == SQ_NONE) {
             return false;
         }
-        Piece my_pawn = (sideToMove == Color::WHITE ? Piece::W_PAWN : Piece::B_PAWN);
-        bool  result  = false;
-        if (enPassant.file() != File::FILE_A) {
-            result = result || piece_on(enPassant + Direction::WEST) == my_pawn;
-        }
-        if (enPassant.file() != File::FILE_H) {
-            result = result || piece_on(enPassant + Direction::EAST) == my_pawn;
-        }
-        return result;
+        Bitboard attackers = pawn_attacks[other_color(c)][enPassant.to_int()];
+        return (attackers & pieces(c, PieceType::PAWN)).any();
     }
 
-    constexpr Bitboard pieces(Color c) const {
-        return pieceBB[c][PieceType::PAWN] | pieceBB[c][PieceType::KNIGHT]
-             | pieceBB[c][PieceType::BISHOP] | pieceBB[c][PieceType::ROOK]
-             | pieceBB[c][PieceType::QUEEN] | pieceBB[c][PieceType::KING];
-    }
+    bool has_en_passant_capture() const { return has_en_passant_capture(sideToMove); }
+
+    constexpr Bitboard pieces(Color c) const { return byColorBB[c]; }
+
+    constexpr Bitboard pieces(Color c, PieceType pt) const { return byTypeBB[pt] & byColorBB[c]; }
 
-    constexpr Bitboard pieces(Color c, PieceType pt) const { return pieceBB[c][pt]; }
+    constexpr Bitboard pieces() const { return occupiedBB; }
+
+    // Returns the number of pieces of type `pt` owned by `c`.
+    constexpr int count(Color c, PieceType pt) const { return pieceCount[c][pt]; }
 
     // Returns the piece on `sq`.
     constexpr Piece piece_on(Square sq) const { return board[sq.to_int()]; }
@@ -88,8 +118,11 @@ class Position {
     // Returns if `sq` is being attacked by `c`. Doesn't consider en passant.
     bool attacks_by(Square sq, Color c) const;
 
-    // Apply a move on the board and returns true if the given move is legal.
-    bool make_move(Move m, UndoInfo& info);
+    // Returns the pieces of `c` attacking `sq`, with sliders blocked by `occupied`.
+    Bitboard attackers_to(Square sq, Color c, Bitboard occupied) const;
+
+    // Apply a legal move on the board.
+    void make_move(Move m, UndoInfo& info);
 
     // Undo a move.
     void unmake_move(const UndoInfo& info);
@@ -100,31 +133,33 @@ class Position {
     // Undo a null move.
     void unmake_null_move(const UndoInfo& info);
 
-    // Check if the current position occurs before.
+    // Check if the current position occurs before. Only positions since the last irreversible
+    // move or null move can repeat, and the closest one with the same side to move is four plies
+    // back.
     bool is_repetition() const {
-        for (int i = 2; i < std::min(history_count, rule50); i += 2) {
-            if (history_keys[history_count - i] == key) {
+        int size = int(history.size());
+        int end  = std::min({size, rule50, pliesFromNull});
+        for (int i = 4; i <= end; i += 2) {
+            if (history[size - i] == key) {
                 return true;
             }
         }
         return false;
     }
 
+    // Returns if the side to move has a reversible move to a position that occurred before, i.e. it
+    // can force a repetition. `ply` is the distance from the search root; before the root only a
+    // position that has already repeated counts.
+    bool has_game_cycle(int ply) const;
+
     // Check if insufficient mating material.
     constexpr bool insufficient_material() const {
-        if (pieceBB[Color::WHITE][PieceType::PAWN].any()
-            || pieceBB[Color::WHITE][PieceType::KNIGHT].count() > 1
-            || pieceBB[Color::WHITE][PieceType::BISHOP].count() > 1
-            || pieceBB[Color::WHITE][PieceType::ROOK].any()
-            || pieceBB[Color::WHITE][PieceType::QUEEN].any()) {
-            return false;
-        }
-        if (pieceBB[Color::BLACK][PieceType::PAWN].any()
-            || pieceBB[Color::BLACK][PieceType::KNIGHT].count() > 1
-            || pieceBB[Color::BLACK][PieceType::BISHOP].count() > 1
-            || pieceBB[Color::BLACK][PieceType::ROOK].any()
-            || pieceBB[Color::BLACK][PieceType::QUEEN].any()) {
-            return false;
+        for (Color c : {Color::WHITE, Color::BLACK}) {
+            if (pieceCount[c][PieceType::PAWN] > 0 || pieceCount[c][PieceType::ROOK] > 0
+                || pieceCount[c][PieceType::QUEEN] > 0
+                || pieceCount[c][PieceType::KNIGHT] + pieceCount[c][PieceType::BISHOP] > 1) {
+                return false;
+            }
         }
         return true;
     }
@@ -135,42 +170,66 @@ class Position {
     std::string to_string() const;
 
    private:
+    // Move making specialized by the side that makes the move.
+    template<Color Us>
+    void make_move(Move m, UndoInfo& info);
+#if !defined(USE_COPY_MAKE)
+    template<Color Us>
+    void unmake_move(const UndoInfo& info);
+#endif
+
     void clear_board() {
         for (int i = 0; i < Square::SQ_NB; i++) {
             board[i] = Piece::NO_PIECE;
         }
         for (int i = 0; i < Color::COLOR_NB; i++) {
+            byColorBB[i] = Bitboard(0);
             for (int j = 0; j < PieceType::PIECE_NB; j++) {
-                pieceBB[i][j] = Bitboard(0);
+                pieceCount[i][j] = 0;
             }
         }
+        for (int i = 0; i < PieceType::PIECE_NB; i++) {
+            byTypeBB[i] = Bitboard(0);
+        }
+        occupiedBB  = Bitboard(0);
+        materialKey = 0;
     }
 
     void add_piece(Square sq, Piece p) {
         board[sq.to_int()] = p;
-        pieceBB[color(p)][type(p)] += sq;
+        byTypeBB[type(p)] += sq;
+        byColorBB[color(p)] += sq;
+        occupiedBB += sq;
         key ^= zobrist_key(sq, p);
+        materialKey ^= zobrist_material_key(p, pieceCount[color(p)][type(p)]++);
+    }
+
+    // Moves a piece to an empty square; the material key does not change.
+    void move_piece(Square from, Square to) {
+        Piece p              = board[from.to_int()];
+        board[from.to_int()] = Piece::NO_PIECE;
+        board[to.to_int()]   = p;
+        Bitboard from_to     = Bitboard(from.to_bb() | to.to_bb());
+        byTypeBB[type(p)] ^= from_to;
+        byColorBB[color(p)] ^= from_to;
+        occupiedBB ^= from_to;
+        key ^= zobrist_key(from, p) ^ zobrist_key(to, p);
     }
 
     void remove_piece(Square sq) {
         Piece p = board[sq.to_int()];
         if (p != Piece::NO_PIECE) {
             board[sq.to_int()] = Piece::NO_PIECE;
-            pieceBB[color(p)][type(p)] -= sq;
+            byTypeBB[type(p)] -= sq;
+            byColorBB[color(p)] -= sq;
+            occupiedBB -= sq;
             key ^= zobrist_key(sq, p);
+            materialKey ^= zobrist_material_key(p, --pieceCount[color(p)][type(p)]);
         }
     }
 
-    Color                                sideToMove;
-    Piece                                board[Square::SQ_NB];
-    Bitboard                             pieceBB[Color::COLOR_NB][PieceType::PIECE_NB];
-    int                                  gamePly;
-    int                                  rule50;
-    Castling                             castlings;
-    Square                               enPassant;
-    std::uint64_t                        key;
-    std::array<std::uint64_t, MAX_MOVES> history_keys = {};
-    int                                  history_count;
+    // Keys of the positions before the current one, most recent last.
+    std::vector<std::uint64_t> history;
 };
 
 } // namespace sonic
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 
 #include "bitboard.h"
@@ -245,4 +246,11 @@ constexpr std::uint64_t zobrist_key(Square sq) {
 
 constexpr std::uint64_t zobrist_key(Color c) { return c == Color::WHITE ? ZobristKeys[780] : 0ULL; }
 
+// Material signature key of the `count`-th piece `p` on the board. Reuses the piece-square keys
+// with the piece count in place of the square.
+constexpr std::uint64_t zobrist_material_key(Piece p, int count) {
+    assert(count < Square::SQ_NB);
+    return zobrist_key(Square(std::uint8_t(count)), p);
+}
+
 } // namespace sonic
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "endgame.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "chess/all.h"
+#include "types.h"
+
+namespace sonic {
+
+namespace {
+
+constexpr Value PawnValueEg   = 100;
+constexpr Value KnightValueEg = 320;
+constexpr Value BishopValueEg = 330;
+constexpr Value RookValueEg   = 510;
+constexpr Value QueenValueEg  = 1010;
+
+constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+// Flips the square vertically if `c` is black.
+Square relative_square(Color c, Square sq) {
+    return c == Color::WHITE ? sq : Square(std::uint8_t(sq.to_int() ^ 56));
+}
+
+// Mirrors the square horizontally.
+Square flip_file(Square sq) { return Square(std::uint8_t(sq.to_int() ^ 7)); }
+
+Square first_square(Bitboard bb) { return Square(lsb(bb.to_int())); }
+
+// Bonus for driving a king towards the edge of the board.
+int push_to_edge(Square sq) {
+    int rank_dist = std::min(sq.row(), 7 - sq.row());
+    int file_dist = std::min(sq.col(), 7 - sq.col());
+    return 100 - 10 * (rank_dist + file_dist + std::min(rank_dist, file_dist));
+}
+
+// Bonus for driving a king towards the A1 or H8 corner.
+int push_to_corner(Square sq) { return std::abs(7 - sq.row() - sq.col()); }
+
+// Bonus for keeping the two kings close.
+int push_close(Square a, Square b) { return 140 - 20 * distance(a, b); }
+
+// KPK bitbase, indexed by side to move, both kings and the pawn square. The pawn is white and
+// normalized to files A-D, ranks 2-7.
+constexpr int KPK_SIZE = 2 * 24 * 64 * 64;
+
+std::uint32_t KPKBitbase[KPK_SIZE / 32];
+
+int kpk_index(Color stm, Square bksq, Square wksq, Square psq) {
+    return wksq.to_int() | (bksq.to_int() << 6) | (stm << 12) | (psq.col() << 13)
+         | ((Rank::RANK_7 - psq.row()) << 15);
+}
+
+enum KPKResult : std::uint8_t {
+    INVALID = 0,
+    UNKNOWN = 1,
+    DRAW    = 2,
+    WIN     = 4
+};
+
+struct KPKPosition {
+    KPKPosition() = default;
+    explicit KPKPosition(int idx);
+
+    KPKResult classify(const std::vector<KPKPosition>& db);
+
+    Color     stm;
+    Square    ksq[Color::COLOR_NB];
+    Square    psq;
+    KPKResult result;
+};
+
+KPKPosition::KPKPosition(int idx) {
+    ksq[Color::WHITE]   = Square(std::uint8_t(idx & 63));
+    ksq[Color::BLACK]   = Square(std::uint8_t((idx >> 6) & 63));
+    stm                 = Color((idx >> 12) & 1);
+    psq                 = Square(File((idx >> 13) & 3), Rank(Rank::RANK_7 - ((idx >> 15) & 7)));
+    Square promotion_sq = psq + Direction::NORTH;
+
+    const Bitboard& white_king_attacks = king_attacks[ksq[Color::WHITE].to_int()];
+    const Bitboard& black_king_attacks = king_attacks[ksq[Color::BLACK].to_int()];
+    const Bitboard& white_pawn_attacks = pawn_attacks[Color::WHITE][psq.to_int()];
+
+    if (distance(ksq[Color::WHITE], ksq[Color::BLACK]) <= 1 || ksq[Color::WHITE] == psq
+        || ksq[Color::BLACK] == psq
+        || (stm == Color::WHITE && white_pawn_attacks.get(ksq[Color::BLACK]))) {
+        result = INVALID;
+    } else if (stm == Color::WHITE && psq.rank() == Rank::RANK_7
+               && ksq[Color::WHITE] != promotion_sq
+               && (distance(ksq[Color::BLACK], promotion_sq) > 1
+                   || distance(ksq[Color::WHITE], promotion_sq) == 1)) {
+        // The pawn promotes without being captured.
+        result = WIN;
+    } else if (stm == Color::BLACK
+               && ((black_king_attacks - (white_king_attacks | white_pawn_attacks)).empty()
+                   || (black_king_attacks - white_king_attacks).get(psq))) {
+        // Stalemate, or the black king captures an undefended pawn.
+        result = DRAW;
+    } else {
+        result = UNKNOWN;
+    }
+}
+
+KPKResult KPKPosition::classify(const std::vector<KPKPosition>& db) {
+    // White wins if any move leads to a win, black draws if any move leads to a draw.
+    const KPKResult good = (stm == Color::WHITE ? WIN : DRAW);
+    const KPKResult bad  = (stm == Color::WHITE ? DRAW : WIN);
+
+    int r = INVALID;
+    for (Square to : king_attacks[ksq[stm].to_int()]) {
+        r |= (stm == Color::WHITE ? db[kpk_index(Color::BLACK, ksq[Color::BLACK], to, psq)].result
+                                  : db[kpk_index(Color::WHITE, to, ksq[Color::WHITE], psq)].result);
+    }
+    if (stm == Color::WHITE) {
+        Square one_step = psq + Direction::NORTH;
+        if (psq.rank() < Rank::RANK_7) {
+            r |= db[kpk_index(Color::BLACK, ksq[Color::BLACK], ksq[Color::WHITE], one_step)].result;
+        }
+        if (psq.rank() == Rank::RANK_2 && one_step != ksq[Color::WHITE]
+            && one_step != ksq[Color::BLACK]) {
+            Square two_step = one_step + Direction::NORTH;
+            r |= db[kpk_index(Color::BLACK, ksq[Color::BLACK], ksq[Color::WHITE], two_step)].result;
+        }
+    }
+    return result = (r & good) ? good : (r & UNKNOWN) ? UNKNOWN : bad;
+}
+
+void init_kpk_bitbase() {
+    std::vector<KPKPosition> db(KPK_SIZE);
+    for (int idx = 0; idx < KPK_SIZE; idx++) {
+        db[idx] = KPKPosition(idx);
+    }
+    // Retrograde analysis until no position changes.
+    bool repeat = true;
+    while (repeat) {
+        repeat = false;
+        for (KPKPosition& p : db) {
+            if (p.result == UNKNOWN) {
+                repeat |= (p.classify(db) != UNKNOWN);
+            }
+        }
+    }
+    for (int idx = 0; idx < KPK_SIZE; idx++) {
+        if (db[idx].result == WIN) {
+            KPKBitbase[idx / 32] |= std::uint32_t(1) << (idx & 31);
+        }
+    }
+}
+
+bool kpk_probe(Square wksq, Square wpsq, Square bksq, Color stm) {
+    assert(wpsq.file() <= File::FILE_D);
+    int idx = kpk_index(stm, bksq, wksq, wpsq);
+    return KPKBitbase[idx / 32] & (std::uint32_t(1) << (idx & 31));
+}
+
+// King and pawn against king, probed from the bitbase.
+Value evaluate_kpk(const Position& pos, Color strong_side) {
+    Color  weak_side = other_color(strong_side);
+    Square wksq      = relative_square(strong_side, pos.king_square(strong_side));
+    Square bksq      = relative_square(strong_side, pos.king_square(weak_side));
+    Square psq =
+        relative_square(strong_side, first_square(pos.pieces(strong_side, PieceType::PAWN)));
+    Color stm = (pos.side_to_move() == strong_side ? Color::WHITE : Color::BLACK);
+    if (psq.file() >= File::FILE_E) {
+        wksq = flip_file(wksq);
+        bksq = flip_file(bksq);
+        psq  = flip_file(psq);
+    }
+    if (!kpk_probe(wksq, psq, bksq, stm)) {
+        return VALUE_DRAW;
+    }
+    Value result = VALUE_KNOWN_WIN + PawnValueEg + psq.row();
+    return pos.side_to_move() == strong_side ? result : -result;
+}
+
+// King, bishop and knight against king. Drive the weak king to a corner of the bishop's color.
+Value evaluate_kbnk(const Position& pos, Color strong_side) {
+    Square strong_king = pos.king_square(strong_side);
+    Square weak_king   = pos.king_square(other_color(strong_side));
+    if ((pos.pieces(strong_side, PieceType::BISHOP) & DARK_SQUARES).empty()) {
+        weak_king = flip_file(weak_king);
+    }
+    Value result =
+        VALUE_KNOWN_WIN + push_close(strong_king, weak_king) + 50 * push_to_corner(weak_king);
+    return pos.side_to_move() == strong_side ? result : -result;
+}
+
+// King and rook against king and pawn.
+Value evaluate_krkp(const Position& pos, Color strong_side) {
+    Color  weak_side = other_color(strong_side);
+    Square wksq      = relative_square(strong_side, pos.king_square(strong_side));
+    Square bksq      = relative_square(strong_side, pos.king_square(weak_side));
+    Square rsq =
+        relative_square(strong_side, first_square(pos.pieces(strong_side, PieceType::ROOK)));
+    Square psq =
+        relative_square(strong_side, first_square(pos.pieces(weak_side, PieceType::PAWN)));
+    Square queening_sq    = Square(psq.file(), Rank::RANK_1);
+    bool   strong_to_move = (pos.side_to_move() == strong_side);
+    Value  result;
+    if (wksq.file() == psq.file() && wksq.row() < psq.row()) {
+        // The strong king is in front of the pawn.
+        result = RookValueEg - distance(wksq, psq);
+    } else if (distance(bksq, psq) >= 3 + !strong_to_move && distance(bksq, rsq) >= 3) {
+        // The weak king is too far away from both the pawn and the rook.
+        result = RookValueEg - distance(wksq, psq);
+    } else if (bksq.rank() <= Rank::RANK_3 && distance(bksq, psq) == 1
+               && wksq.rank() >= Rank::RANK_4 && distance(wksq, psq) > 2 + strong_to_move) {
+        // The pawn is far advanced and supported by its king.
+        result = 80 - 8 * distance(wksq, psq);
+    } else {
+        Square stop_sq = psq + Direction::SOUTH;
+        int    tempo   = distance(wksq, stop_sq) - distance(bksq, stop_sq);
+        result         = 200 - 8 * (tempo - distance(psq, queening_sq));
+    }
+    return strong_to_move ? result : -result;
+}
+
+// Two knights can't force mate against a bare king.
+Value evaluate_knnk(const Position&, Color) { return VALUE_DRAW; }
+
+std::unordered_map<std::uint64_t, Endgame> endgames;
+
+// Returns the material key of an endgame code like "KBNK", with the first king belonging to
+// `strong_side`.
+std::uint64_t endgame_material_key(const std::string& code, Color strong_side) {
+    std::uint64_t key = 0;
+    Color         c   = other_color(strong_side);
+    int           counts[Color::COLOR_NB][PieceType::PIECE_NB] = {};
+    for (char ch : code) {
+        PieceType pt = PieceType::NO_PIECE_TYPE;
+        switch (ch) {
+        case 'K' :
+            pt = PieceType::KING;
+            c  = other_color(c);
+            break;
+        case 'Q' :
+            pt = PieceType::QUEEN;
+            break;
+        case 'R' :
+            pt = PieceType::ROOK;
+            break;
+        case 'B' :
+            pt = PieceType::BISHOP;
+            break;
+        case 'N' :
+            pt = PieceType::KNIGHT;
+            break;
+        case 'P' :
+            pt = PieceType::PAWN;
+            break;
+        default :
+            assert(false);
+        }
+        key ^= zobrist_material_key(make_piece(c, pt), counts[c][pt]++);
+    }
+    return key;
+}
+
+void add_endgame(const std::string& code, EndgameFunction function) {
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        endgames[endgame_material_key(code, c)] = Endgame{function, c};
+    }
+}
+
+} // namespace
+
+Value evaluate_kxk(const Position& pos, Color strong_side) {
+    Square   strong_king = pos.king_square(strong_side);
+    Square   weak_king   = pos.king_square(other_color(strong_side));
+    Bitboard bishops     = pos.pieces(strong_side, PieceType::BISHOP);
+    Value    result      = pos.count(strong_side, PieceType::PAWN) * PawnValueEg
+                 + pos.count(strong_side, PieceType::KNIGHT) * KnightValueEg
+                 + pos.count(strong_side, PieceType::BISHOP) * BishopValueEg
+                 + pos.count(strong_side, PieceType::ROOK) * RookValueEg
+                 + pos.count(strong_side, PieceType::QUEEN) * QueenValueEg
+                 + push_to_edge(weak_king) + push_close(strong_king, weak_king);
+    if (pos.count(strong_side, PieceType::QUEEN) > 0 || pos.count(strong_side, PieceType::ROOK) > 0
+        || (pos.count(strong_side, PieceType::BISHOP) > 0
+            && pos.count(strong_side, PieceType::KNIGHT) > 0)
+        || ((bishops & DARK_SQUARES).any() && (bishops - DARK_SQUARES).any())) {
+        result = std::min(result + VALUE_KNOWN_WIN, VALUE_MATE - MAX_DEPTH - 1);
+    }
+    return pos.side_to_move() == strong_side ? result : -result;
+}
+
+void init_endgames() {
+    init_kpk_bitbase();
+    add_endgame("KPK", evaluate_kpk);
+    add_endgame("KBNK", evaluate_kbnk);
+    add_endgame("KRKP", evaluate_krkp);
+    add_endgame("KNNK", evaluate_knnk);
+}
+
+const Endgame* find_endgame(std::uint64_t material_key) {
+    auto it = endgames.find(material_key);
+    return it == endgames.end() ? nullptr : &it->second;
+}
+
+} // namespace sonic
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "chess/all.h"
+#include "types.h"
+
+namespace sonic {
+
+// Evaluates a specific endgame from the point of view of the side to move.
+using EndgameFunction = Value (*)(const Position& pos, Color strong_side);
+
+struct Endgame {
+    EndgameFunction evaluate    = nullptr;
+    Color           strong_side = Color::COLOR_NONE;
+};
+
+// Builds the KPK bitbase and the endgame lookup table.
+void init_endgames();
+
+// Returns the specialized evaluation for the given material signature, or nullptr if none.
+const Endgame* find_endgame(std::uint64_t material_key);
+
+// Mate with king and enough material against a bare king.
+Value evaluate_kxk(const Position& pos, Color strong_side);
+
+} // namespace sonic
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <utility>
+
+#include "chess/all.h"
+#include "types.h"
+
+namespace sonic {
+
+// Evaluation parameters, from white's point of view. This file is generated by `tune-eval`.
+
+// clang-format off
+constexpr std::pair<Value, Value> PieceSquareTable[PieceType::PIECE_NB][Square::SQ_NB] = {
+    { // Pawn
+        {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+        {166, 256}, {192, 256}, {204, 256}, {216, 256}, {216, 256}, {204, 256}, {192, 256}, {166, 256},
+        {166, 256}, {192, 256}, {210, 256}, {242, 256}, {242, 256}, {210, 256}, {192, 256}, {166, 256},
+        {166, 256}, {192, 256}, {220, 256}, {268, 256}, {268, 256}, {220, 256}, {192, 256}, {166, 256},
+        {166, 256}, {192, 256}, {220, 256}, {242, 256}, {242, 256}, {220, 256}, {192, 256}, {166, 256},
+        {166, 256}, {192, 256}, {210, 256}, {216, 256}, {216, 256}, {210, 256}, {192, 256}, {166, 256},
+        {166, 256}, {192, 256}, {204, 256}, {216, 256}, {216, 256}, {204, 256}, {192, 256}, {166, 256},
+        {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+    },
+    { // Knight
+        {704, 730}, {730, 756}, {756, 781}, {768, 794}, {768, 794}, {756, 781}, {730, 756}, {704, 730},
+        {743, 756}, {768, 781}, {794, 807}, {807, 820}, {807, 820}, {794, 807}, {768, 781}, {743, 756},
+        {781, 781}, {807, 807}, {832, 832}, {844, 844}, {844, 844}, {832, 832}, {807, 807}, {781, 781},
+        {807, 794}, {832, 820}, {857, 844}, {870, 857}, {870, 857}, {857, 844}, {832, 820}, {807, 794},
+        {820, 794}, {844, 820}, {870, 844}, {883, 857}, {883, 857}, {870, 844}, {844, 820}, {820, 794},
+        {820, 781}, {844, 807}, {870, 832}, {883, 844}, {883, 844}, {870, 832}, {844, 807}, {820, 781},
+        {781, 756}, {807, 781}, {832, 807}, {844, 820}, {844, 820}, {832, 807}, {807, 781}, {781, 756},
+        {650, 730}, {768, 756}, {794, 781}, {807, 794}, {807, 794}, {794, 781}, {768, 756}, {650, 730},
+    },
+    { // Bishop
+        {786, 786}, {786, 802}, {792, 809}, {797, 817}, {797, 817}, {792, 809}, {786, 802}, {786, 786},
+        {812, 802}, {832, 817}, {827, 825}, {832, 832}, {832, 832}, {827, 825}, {832, 817}, {812, 802},
+        {817, 809}, {827, 825}, {842, 832}, {837, 839}, {837, 839}, {842, 832}, {827, 825}, {817, 809},
+        {822, 817}, {832, 832}, {837, 839}, {852, 847}, {852, 847}, {837, 839}, {832, 832}, {822, 817},
+        {822, 817}, {832, 832}, {837, 839}, {852, 847}, {852, 847}, {837, 839}, {832, 832}, {822, 817},
+        {817, 809}, {827, 825}, {842, 832}, {837, 839}, {837, 839}, {842, 832}, {827, 825}, {817, 809},
+        {812, 802}, {832, 817}, {827, 825}, {832, 832}, {832, 832}, {827, 825}, {832, 817}, {812, 802},
+        {812, 786}, {812, 802}, {817, 809}, {822, 817}, {822, 817}, {817, 809}, {812, 802}, {812, 786},
+    },
+    { // Rook
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
+    },
+    { // Queen
+        {2560, 2499}, {2560, 2520}, {2560, 2530}, {2560, 2540}, {2560, 2540}, {2560, 2530}, {2560, 2520}, {2560, 2499},
+        {2560, 2520}, {2560, 2540}, {2560, 2550}, {2560, 2560}, {2560, 2560}, {2560, 2550}, {2560, 2540}, {2560, 2520},
+        {2560, 2530}, {2560, 2550}, {2560, 2560}, {2560, 2570}, {2560, 2570}, {2560, 2560}, {2560, 2550}, {2560, 2530},
+        {2560, 2540}, {2560, 2560}, {2560, 2570}, {2560, 2580}, {2560, 2580}, {2560, 2570}, {2560, 2560}, {2560, 2540},
+        {2560, 2540}, {2560, 2560}, {2560, 2570}, {2560, 2580}, {2560, 2580}, {2560, 2570}, {2560, 2560}, {2560, 2540},
+        {2560, 2530}, {2560, 2550}, {2560, 2560}, {2560, 2570}, {2560, 2570}, {2560, 2560}, {2560, 2550}, {2560, 2530},
+        {2560, 2520}, {2560, 2540}, {2560, 2550}, {2560, 2560}, {2560, 2560}, {2560, 2550}, {2560, 2540}, {2560, 2520},
+        {2560, 2499}, {2560, 2520}, {2560, 2530}, {2560, 2540}, {2560, 2540}, {2560, 2530}, {2560, 2520}, {2560, 2499},
+    },
+    { // King
+        {302, 16}, {328, 78}, {276, 108}, {225, 139}, {225, 139}, {276, 108}, {328, 78}, {302, 16},
+        {276, 78}, {302, 139}, {251, 170}, {200, 200}, {200, 200}, {251, 170}, {302, 139}, {276, 78},
+        {225, 108}, {251, 170}, {200, 200}, {149, 230}, {149, 230}, {200, 200}, {251, 170}, {225, 108},
+        {200, 139}, {225, 200}, {175, 230}, {124, 261}, {124, 261}, {175, 230}, {225, 200}, {200, 139},
+        {175, 139}, {200, 200}, {149, 230}, {98, 261}, {98, 261}, {149, 230}, {200, 200}, {175, 139},
+        {149, 108}, {175, 170}, {124, 200}, {72, 230}, {72, 230}, {124, 200}, {175, 170}, {149, 108},
+        {124, 78}, {149, 139}, {98, 170}, {47, 200}, {47, 200}, {98, 170}, {149, 139}, {124, 78},
+        {98, 16}, {124, 78}, {72, 108}, {21, 139}, {21, 139}, {72, 108}, {124, 78}, {98, 16},
+    },
+};
+
+constexpr std::pair<Value, Value> MobilityMult[PieceType::PIECE_NB] = {
+    {0, 0}, {6, 6}, {2, 3}, {3, 6}, {2, 7}, {0, 0},
+};
+
+constexpr std::pair<Value, Value> PassedPawnBonus[8] = {
+    {0, 0}, {25, 37}, {50, 75}, {75, 112}, {100, 150}, {125, 187}, {150, 225}, {0, 0},
+};
+// clang-format on
+
+} // namespace sonic
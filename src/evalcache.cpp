@@ -0,0 +1,26 @@
+#include "evalcache.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sonic {
+
+thread_local EvalCache eval_cache(1);
+
+void EvalCache::resize(std::size_t mbSize) {
+    constexpr int MB       = 1024 * 1024;
+    std::size_t   new_size = 1;
+    // Size must be power of 2.
+    while (new_size * 2 * sizeof(std::uint64_t) <= mbSize * MB) {
+        new_size *= 2;
+    }
+    if (new_size != size) {
+        size = new_size;
+        entries.resize(size);
+        clear();
+    }
+}
+
+void EvalCache::clear() { std::fill(entries.begin(), entries.end(), 0); }
+
+} // namespace sonic
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace sonic {
+
+// Direct-mapped cache of static evaluations. Each entry packs the upper 48 bits of the zobrist key
+// and the 16-bit score into a single word.
+class EvalCache {
+   public:
+    EvalCache() = default;
+
+    EvalCache(std::size_t mbSize) { resize(mbSize); }
+
+    void resize(std::size_t mbSize);
+    void clear();
+
+    bool probe(std::uint64_t key, Value& score) {
+        probes++;
+        std::uint64_t entry = entries[key & (size - 1)];
+        if (((entry ^ key) & KEY_MASK) != 0) {
+            return false;
+        }
+        hits++;
+        score = Value(std::int16_t(entry & SCORE_MASK));
+        return true;
+    }
+
+    void store(std::uint64_t key, Value score) {
+        entries[key & (size - 1)] = (key & KEY_MASK) | std::uint16_t(score);
+    }
+
+    // Statistics since the last call of `reset_stats()`.
+    std::uint64_t probes = 0;
+    std::uint64_t hits   = 0;
+
+    void reset_stats() { probes = hits = 0; }
+
+   private:
+    static constexpr std::uint64_t SCORE_MASK = 0xFFFF;
+    static constexpr std::uint64_t KEY_MASK   = ~SCORE_MASK;
+
+    std::size_t                size = 0;
+    std::vector<std::uint64_t> entries;
+};
+
+// Evaluation cache of the current thread.
+extern thread_local EvalCache eval_cache;
+
+} // namespace sonic
@@ -2,80 +2,12 @@
 
 #include "chess/all.h"
 #include "utils/bits.h"
+#include "eval_params.h"
+#include "material.h"
 #include "types.h"
 
 namespace sonic {
 
-// clang-format off
-constexpr std::pair<Value, Value> PieceSquareTable[PieceType::PIECE_NB][Square::SQ_NB] = {
-    { // Pawn
-        {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
-        {166, 256}, {192, 256}, {204, 256}, {216, 256}, {216, 256}, {204, 256}, {192, 256}, {166, 256},
-        {166, 256}, {192, 256}, {210, 256}, {242, 256}, {242, 256}, {210, 256}, {192, 256}, {166, 256},
-        {166, 256}, {192, 256}, {220, 256}, {268, 256}, {268, 256}, {220, 256}, {192, 256}, {166, 256},
-        {166, 256}, {192, 256}, {220, 256}, {242, 256}, {242, 256}, {220, 256}, {192, 256}, {166, 256},
-        {166, 256}, {192, 256}, {210, 256}, {216, 256}, {216, 256}, {210, 256}, {192, 256}, {166, 256},
-        {166, 256}, {192, 256}, {204, 256}, {216, 256}, {216, 256}, {204, 256}, {192, 256}, {166, 256},
-        {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
-    },
-    { // Knight
-        {704, 730}, {730, 756}, {756, 781}, {768, 794}, {768, 794}, {756, 781}, {730, 756}, {704, 730},
-        {743, 756}, {768, 781}, {794, 807}, {807, 820}, {807, 820}, {794, 807}, {768, 781}, {743, 756},
-        {781, 781}, {807, 807}, {832, 832}, {844, 844}, {844, 844}, {832, 832}, {807, 807}, {781, 781},
-        {807, 794}, {832, 820}, {857, 844}, {870, 857}, {870, 857}, {857, 844}, {832, 820}, {807, 794},
-        {820, 794}, {844, 820}, {870, 844}, {883, 857}, {883, 857}, {870, 844}, {844, 820}, {820, 794},
-        {820, 781}, {844, 807}, {870, 832}, {883, 844}, {883, 844}, {870, 832}, {844, 807}, {820, 781},
-        {781, 756}, {807, 781}, {832, 807}, {844, 820}, {844, 820}, {832, 807}, {807, 781}, {781, 756},
-        {650, 730}, {768, 756}, {794, 781}, {807, 794}, {807, 794}, {794, 781}, {768, 756}, {650, 730},
-    },
-    { // Bishop
-        {786, 786}, {786, 802}, {792, 809}, {797, 817}, {797, 817}, {792, 809}, {786, 802}, {786, 786},
-        {812, 802}, {832, 817}, {827, 825}, {832, 832}, {832, 832}, {827, 825}, {832, 817}, {812, 802},
-        {817, 809}, {827, 825}, {842, 832}, {837, 839}, {837, 839}, {842, 832}, {827, 825}, {817, 809},
-        {822, 817}, {832, 832}, {837, 839}, {852, 847}, {852, 847}, {837, 839}, {832, 832}, {822, 817},
-        {822, 817}, {832, 832}, {837, 839}, {852, 847}, {852, 847}, {837, 839}, {832, 832}, {822, 817},
-        {817, 809}, {827, 825}, {842, 832}, {837, 839}, {837, 839}, {842, 832}, {827, 825}, {817, 809},
-        {812, 802}, {832, 817}, {827, 825}, {832, 832}, {832, 832}, {827, 825}, {832, 817}, {812, 802},
-        {812, 786}, {812, 802}, {817, 809}, {822, 817}, {822, 817}, {817, 809}, {812, 802}, {812, 786},
-    },
-    { // Rook
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-        {1267, 1282}, {1275, 1282}, {1282, 1282}, {1289, 1282}, {1289, 1282}, {1282, 1282}, {1275, 1282}, {1267, 1282},
-    },
-    { // Queen
-        {2560, 2499}, {2560, 2520}, {2560, 2530}, {2560, 2540}, {2560, 2540}, {2560, 2530}, {2560, 2520}, {2560, 2499},
-        {2560, 2520}, {2560, 2540}, {2560, 2550}, {2560, 2560}, {2560, 2560}, {2560, 2550}, {2560, 2540}, {2560, 2520},
-        {2560, 2530}, {2560, 2550}, {2560, 2560}, {2560, 2570}, {2560, 2570}, {2560, 2560}, {2560, 2550}, {2560, 2530},
-        {2560, 2540}, {2560, 2560}, {2560, 2570}, {2560, 2580}, {2560, 2580}, {2560, 2570}, {2560, 2560}, {2560, 2540},
-        {2560, 2540}, {2560, 2560}, {2560, 2570}, {2560, 2580}, {2560, 2580}, {2560, 2570}, {2560, 2560}, {2560, 2540},
-        {2560, 2530}, {2560, 2550}, {2560, 2560}, {2560, 2570}, {2560, 2570}, {2560, 2560}, {2560, 2550}, {2560, 2530},
-        {2560, 2520}, {2560, 2540}, {2560, 2550}, {2560, 2560}, {2560, 2560}, {2560, 2550}, {2560, 2540}, {2560, 2520},
-        {2560, 2499}, {2560, 2520}, {2560, 2530}, {2560, 2540}, {2560, 2540}, {2560, 2530}, {2560, 2520}, {2560, 2499},
-    },
-    { // King
-        {302,  16}, {328,  78}, {276, 108}, {225, 139}, {225, 139}, {276, 108}, {328,  78}, {302,  16},
-        {276,  78}, {302, 139}, {251, 170}, {200, 200}, {200, 200}, {251, 170}, {302, 139}, {276,  78},
-        {225, 108}, {251, 170}, {200, 200}, {149, 230}, {149, 230}, {200, 200}, {251, 170}, {225, 108},
-        {200, 139}, {225, 200}, {175, 230}, {124, 261}, {124, 261}, {175, 230}, {225, 200}, {200, 139},
-        {175, 139}, {200, 200}, {149, 230}, { 98, 261}, { 98, 261}, {149, 230}, {200, 200}, {175, 139},
-        {149, 108}, {175, 170}, {124, 200}, { 72, 230}, { 72, 230}, {124, 200}, {175, 170}, {149, 108},
-        {124,  78}, {149, 139}, { 98, 170}, { 47, 200}, { 47, 200}, { 98, 170}, {149, 139}, {124,  78},
-        { 98,  16}, {124,  78}, { 72, 108}, { 21, 139}, { 21, 139}, { 72, 108}, {124,  78}, { 98,  16},
-    },
-};
-// clang-format off
-
-constexpr std::pair<Value, Value> KnightMobilityMult = {6, 6};
-constexpr std::pair<Value, Value> BishopMobilityMult = {2, 3};
-constexpr std::pair<Value, Value> RookMobilityMult = {3, 6};
-constexpr std::pair<Value, Value> QueenMobilityMult = {2, 7};
-
 // clang-format off
 constexpr Bitboard PassedPawnMask[Color::COLOR_NB][Square::SQ_NB] = {
     // White
@@ -103,53 +35,86 @@ constexpr Bitboard PassedPawnMask[Color::COLOR_NB][Square::SQ_NB] = {
 };
 // clang-format on
 
-Value evaluate(const Position& pos) {
-    static constexpr int PieceTypeValues[] = {1, 3, 3, 5, 9};
-    Color                us                = pos.side_to_move();
-    Bitboard             white_pieces      = pos.pieces(Color::WHITE);
-    Bitboard             black_pieces      = pos.pieces(Color::BLACK);
-    Value                mid_game_score    = 0;
-    Value                end_game_score    = 0;
-    int                  phase             = 0;
-    int                  coeff             = 1;
+namespace {
+
+Square relative_square(Color c, Square sq) {
+    return c == Color::WHITE ? sq : Square(std::uint8_t(sq.to_int() ^ 56));
+}
+
+// Evaluation from the side to move's point of view. With `Trace`, the coefficients of every
+// evaluation parameter are recorded instead of taking the lazy exit.
+template<bool Trace>
+Value evaluate(const Position& pos,
+               AttackInfo&     ai,
+               Value           alpha,
+               Value           beta,
+               bool&           lazy,
+               EvalTrace*      trace) {
+    lazy                    = false;
+    MaterialEntry* material = probe_material(pos);
+    if (material->has_endgame()) {
+        if constexpr (Trace) {
+            trace->endgame = true;
+        }
+        return material->evaluate(pos);
+    }
+    Color us             = pos.side_to_move();
+    Value mid_game_score = material->imbalance.first;
+    Value end_game_score = material->imbalance.second;
+    int   phase          = material->phase;
+    if constexpr (Trace) {
+        trace->base  = material->imbalance;
+        trace->phase = phase;
+    }
+
+    // Blend the middle game and end game scores into a score for the side to move.
+    auto blend = [&]() {
+        Color strong_side = (end_game_score > 0 ? Color::WHITE : Color::BLACK);
+        int   factor      = material->scale_factor(strong_side);
+        if constexpr (Trace) {
+            trace->scale = factor;
+        }
+        Value eg    = end_game_score * factor / SCALE_FACTOR_NORMAL;
+        Value score = (mid_game_score * phase + eg * (78 - phase)) / 195;
+        return us == Color::WHITE ? score : -score;
+    };
+
+    // Material and piece-square balance.
+    int coeff = 1;
     for (Color c : {Color::WHITE, Color::BLACK}) {
         for (Square sq : pos.pieces(c)) {
-            PieceType pt = type(pos.piece_on(sq));
-            mid_game_score += coeff * PieceSquareTable[pt][sq.to_int()].first;
-            end_game_score += coeff * PieceSquareTable[pt][sq.to_int()].second;
-            if (pt != PieceType::KING) {
-                phase += PieceTypeValues[pt];
+            PieceType pt  = type(pos.piece_on(sq));
+            int       idx = relative_square(c, sq).to_int();
+            mid_game_score += coeff * PieceSquareTable[pt][idx].first;
+            end_game_score += coeff * PieceSquareTable[pt][idx].second;
+            if constexpr (Trace) {
+                trace->psqt[pt][idx] += coeff;
             }
-            // Piece Mobility Bonus
-            if (pt == PieceType::KNIGHT) {
-                Bitboard to = knight_attacks[sq.to_int()]
-                            - (us == Color::WHITE ? white_pieces : black_pieces);
-                int counts = to.count();
-                mid_game_score += coeff * KnightMobilityMult.first * counts;
-                end_game_score += coeff * KnightMobilityMult.second * counts;
-            }
-            if (pt == PieceType::BISHOP) {
-                Bitboard bishop_attacks = bishop_magics[sq.to_int()](white_pieces | black_pieces);
-                bishop_attacks -= (us == Color::WHITE ? white_pieces : black_pieces);
-                int counts = bishop_attacks.count();
-                mid_game_score += coeff * BishopMobilityMult.first * counts;
-                end_game_score += coeff * BishopMobilityMult.second * counts;
-            }
-            if (pt == PieceType::ROOK) {
-                Bitboard rook_attacks = rook_magics[sq.to_int()](white_pieces | black_pieces);
-                rook_attacks -= (us == Color::WHITE ? white_pieces : black_pieces);
-                int counts = rook_attacks.count();
-                mid_game_score += coeff * RookMobilityMult.first * counts;
-                end_game_score += coeff * RookMobilityMult.second * counts;
-            }
-            if (pt == PieceType::QUEEN) {
-                Bitboard rook_attacks   = rook_magics[sq.to_int()](white_pieces | black_pieces);
-                Bitboard bishop_attacks = bishop_magics[sq.to_int()](white_pieces | black_pieces);
-                Bitboard queen_attacks  = rook_attacks | bishop_attacks;
-                queen_attacks -= (us == Color::WHITE ? white_pieces : black_pieces);
-                int counts = queen_attacks.count();
-                mid_game_score += coeff * QueenMobilityMult.first * counts;
-                end_game_score += coeff * QueenMobilityMult.second * counts;
+        }
+        coeff *= -1;
+    }
+
+    // Lazy exit: the remaining terms cannot bring the score back into the window.
+    if constexpr (!Trace) {
+        Value partial = blend();
+        if (partial <= alpha || partial >= beta) {
+            lazy = true;
+            return partial;
+        }
+    }
+
+    Bitboard my_pieces = pos.pieces(us);
+    coeff              = 1;
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        // Piece Mobility Bonus
+        for (Square sq : pos.pieces(c)
+                             - pos.pieces(c, PieceType::PAWN) - pos.pieces(c, PieceType::KING)) {
+            PieceType pt     = type(pos.piece_on(sq));
+            int       counts = (ai.attacks_from(sq) - my_pieces).count();
+            mid_game_score += coeff * MobilityMult[pt].first * counts;
+            end_game_score += coeff * MobilityMult[pt].second * counts;
+            if constexpr (Trace) {
+                trace->mobility[pt] += coeff * counts;
             }
         }
         // Passed pawn bonus.
@@ -157,17 +122,39 @@ Value evaluate(const Position& pos) {
         for (Square sq : pos.pieces(c, PieceType::PAWN)) {
             Bitboard visible_pawns = PassedPawnMask[c][sq.to_int()] & opponent_pawns;
             if (visible_pawns.empty()) {
-                int promotion_rank = (c == Color::WHITE ? 8 : 1);
-                int bonus = 200 - 25 * std::abs(static_cast<int>(sq.rank()) - promotion_rank);
-                mid_game_score += coeff * bonus;
-                end_game_score += coeff * bonus * 3 / 2;
+                int rank = relative_square(c, sq).rank();
+                mid_game_score += coeff * PassedPawnBonus[rank].first;
+                end_game_score += coeff * PassedPawnBonus[rank].second;
+                if constexpr (Trace) {
+                    trace->passed_pawn[rank] += coeff;
+                }
             }
         }
         coeff *= -1;
     }
-    Value score = mid_game_score * phase + end_game_score * (78 - phase);
-    score /= 195;
-    return us == Color::WHITE ? score : -score;
+    return blend();
+}
+
+} // namespace
+
+Value evaluate(const Position& pos) {
+    AttackInfo ai(pos);
+    return evaluate(pos, ai);
+}
+
+Value evaluate(const Position& pos, AttackInfo& ai) {
+    bool lazy = false;
+    return evaluate<false>(pos, ai, -VALUE_INF, VALUE_INF, lazy, nullptr);
+}
+
+Value evaluate(const Position& pos, AttackInfo& ai, Value alpha, Value beta, bool& lazy) {
+    return evaluate<false>(pos, ai, alpha, beta, lazy, nullptr);
+}
+
+Value evaluate(const Position& pos, EvalTrace& trace) {
+    AttackInfo ai(pos);
+    bool       lazy = false;
+    return evaluate<true>(pos, ai, -VALUE_INF, VALUE_INF, lazy, &trace);
 }
 
-} // namespace sonic
\ No newline at end of file
+} // namespace sonic
@@ -1,10 +1,32 @@
 #pragma once
 
+#include <utility>
+
 #include "chess/all.h"
 #include "types.h"
 
 namespace sonic {
 
+// Coefficients of the evaluation parameters in a position, white minus black. Filled by the
+// tracing evaluation for the tuner.
+struct EvalTrace {
+    int                     psqt[PieceType::PIECE_NB][Square::SQ_NB] = {};
+    int                     mobility[PieceType::PIECE_NB]            = {};
+    int                     passed_pawn[8]                           = {};
+    std::pair<Value, Value> base    = {0, 0}; // Untuned material imbalance.
+    int                     phase   = 0;
+    int                     scale   = 64;
+    bool                    endgame = false; // Evaluated by a specialized endgame function.
+};
+
 Value evaluate(const Position& pos);
+Value evaluate(const Position& pos, AttackInfo& ai);
+
+// Lazy evaluation: when the material and piece-square balance alone is outside (alpha, beta), it
+// is returned without the mobility and pawn terms and `lazy` is set.
+Value evaluate(const Position& pos, AttackInfo& ai, Value alpha, Value beta, bool& lazy);
+
+// Evaluation that also records the parameter coefficients into `trace`.
+Value evaluate(const Position& pos, EvalTrace& trace);
 
 } // namespace sonic
\ No newline at end of file
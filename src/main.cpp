@@ -3,22 +3,37 @@
 #include <string>
 #include <vector>
 
+#include "analyze.h"
 #include "bench/perft.h"
 #include "bench/benchmark.h"
+#include "bench/microbench.h"
 #include "chess/all.h"
 #include "utils/bits.h"
 #include "utils/random.h"
 #include "utils/small_vector.h"
 #include "utils/strings.h"
+#include "endgame.h"
 #include "uci.h"
 #include "search.h"
 
 int main(int argc, char* argv[]) {
     using namespace std;
     using namespace sonic;
-    init_attacks();
+    init_endgames();
     if (argc > 1 && std::string(argv[1]) == "bench") {
-        run_bench();
+        run_bench(std::vector<std::string>(argv + 1, argv + argc));
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "microbench") {
+        run_microbench(std::vector<std::string>(argv + 1, argv + argc));
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "analyze") {
+        analyze(std::vector<std::string>(argv + 1, argv + argc));
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "readtrace") {
+        read_trace(std::vector<std::string>(argv + 1, argv + argc));
         return 0;
     }
     uci_loop();
@@ -0,0 +1,88 @@
+#include "material.h"
+
+#include <cstdint>
+
+#include "chess/all.h"
+#include "endgame.h"
+#include "types.h"
+
+namespace sonic {
+
+namespace {
+
+// Pawn, Knight, Bishop, Rook, Queen
+constexpr int PieceTypeValues[] = {1, 3, 3, 5, 9};
+
+constexpr std::pair<Value, Value> BishopPairBonus = {40, 60};
+
+const Endgame KXKEndgames[Color::COLOR_NB] = {
+    {evaluate_kxk, Color::WHITE},
+    {evaluate_kxk, Color::BLACK},
+};
+
+thread_local MaterialTable material_table;
+
+} // namespace
+
+MaterialEntry* MaterialTable::probe(const Position& pos) {
+    std::uint64_t  key   = pos.material_key();
+    MaterialEntry* entry = &entries[key & (SIZE - 1)];
+    if (entry->key == key) {
+        return entry;
+    }
+    *entry     = MaterialEntry();
+    entry->key = key;
+
+    int non_pawn_material[Color::COLOR_NB] = {};
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        for (PieceType pt : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK,
+                             PieceType::QUEEN}) {
+            non_pawn_material[c] += pos.count(c, pt) * PieceTypeValues[pt];
+        }
+        entry->phase += non_pawn_material[c] + pos.count(c, PieceType::PAWN);
+    }
+
+    // Specialized endgame evaluation.
+    entry->endgame = find_endgame(key);
+    if (entry->has_endgame()) {
+        return entry;
+    }
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        Color them = other_color(c);
+        if (non_pawn_material[them] == 0 && pos.count(them, PieceType::PAWN) == 0
+            && non_pawn_material[c] >= PieceTypeValues[PieceType::ROOK]) {
+            entry->endgame = &KXKEndgames[c];
+            return entry;
+        }
+    }
+
+    // Bishop pair.
+    int coeff = 1;
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        if (pos.count(c, PieceType::BISHOP) > 1) {
+            entry->imbalance.first += coeff * BishopPairBonus.first;
+            entry->imbalance.second += coeff * BishopPairBonus.second;
+        }
+        coeff *= -1;
+    }
+
+    // Without pawns, a small material advantage is hard to convert.
+    constexpr int BishopValue = PieceTypeValues[PieceType::BISHOP];
+    constexpr int RookValue   = PieceTypeValues[PieceType::ROOK];
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        Color them = other_color(c);
+        if (pos.count(c, PieceType::PAWN) == 0
+            && non_pawn_material[c] - non_pawn_material[them] <= BishopValue) {
+            if (non_pawn_material[c] < RookValue) {
+                entry->factor[c] = SCALE_FACTOR_DRAW;
+            } else {
+                entry->factor[c] = (non_pawn_material[them] <= BishopValue ? 4 : 14);
+            }
+        }
+    }
+    return entry;
+}
+
+MaterialEntry* probe_material(const Position& pos) { return material_table.probe(pos); }
+
+} // namespace sonic
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "chess/all.h"
+#include "endgame.h"
+#include "types.h"
+
+namespace sonic {
+
+constexpr int SCALE_FACTOR_DRAW   = 0;
+constexpr int SCALE_FACTOR_NORMAL = 64;
+
+// Material dependent evaluation terms, cached by the material signature of the position.
+struct MaterialEntry {
+    std::uint64_t           key       = 0;
+    int                     phase     = 0;
+    std::pair<Value, Value> imbalance = {0, 0}; // From white's point of view.
+    std::uint8_t            factor[Color::COLOR_NB] = {SCALE_FACTOR_NORMAL, SCALE_FACTOR_NORMAL};
+    const Endgame*          endgame                 = nullptr;
+
+    bool has_endgame() const { return endgame != nullptr; }
+
+    // Evaluates the position with the specialized endgame function.
+    Value evaluate(const Position& pos) const {
+        return endgame->evaluate(pos, endgame->strong_side);
+    }
+
+    // Scale factor of the endgame score when `c` is the stronger side.
+    int scale_factor(Color c) const { return factor[c]; }
+};
+
+class MaterialTable {
+   public:
+    MaterialTable() :
+        entries(SIZE) {}
+
+    MaterialEntry* probe(const Position& pos);
+
+   private:
+    static constexpr std::size_t SIZE = 8192;
+    std::vector<MaterialEntry>   entries;
+};
+
+// Probes the material table of the current thread.
+MaterialEntry* probe_material(const Position& pos);
+
+} // namespace sonic
@@ -12,24 +12,27 @@ void sort_moves(const Position& pos, MoveList& movelist, Move tt_move) {
             return 1000000;
         }
         // 2. Promotions
-        if (m.promotion() == Move::Promotion::Queen) {
-            return 100001;
-        }
-        if (m.promotion() == Move::Promotion::Knight) {
-            return 100000;
+        if (m.is_promotion()) {
+            if (m.promotion_type() == PieceType::QUEEN) {
+                return 100001;
+            }
+            if (m.promotion_type() == PieceType::KNIGHT) {
+                return 100000;
+            }
         }
         // 3. MVV-LVA
         // Pawn, Knight, Bishop, Rook, Queen, King
         static constexpr int AttackValues[6] = {50, 30, 30, 20, 10, 0};
         Piece                from            = pos.piece_on(m.from());
-        Piece                to              = pos.piece_on(m.to());
-        if (pos.is_capture(m)) {
-            return AttackValues[type(from)] - AttackValues[type(to)] + 500;
+        if (m.is_capture()) {
+            PieceType victim =
+                (m.is_en_passant() ? PieceType::PAWN : type(pos.piece_on(m.to())));
+            return AttackValues[type(from)] - AttackValues[victim] + 500;
         }
         // 4. Others
         return -AttackValues[type(from)];
     };
-    static int scores[218];
+    int scores[218];
     for (size_t i = 0; i < movelist.size(); i++) {
         scores[i] = move_score(movelist[i]);
     }
@@ -9,8 +9,10 @@
 #include "utils/misc.h"
 #include "utils/timer.h"
 #include "book.h"
+#include "evalcache.h"
 #include "evaluate.h"
 #include "movesort.h"
+#include "timeline.h"
 #include "tt.h"
 #include "tune.h"
 #include "types.h"
@@ -18,60 +20,144 @@
 
 namespace sonic {
 
-Value qsearch(Position& pos, SearchInfo& search_info, Value alpha, Value beta) {
+// Static evaluation, looked up in the evaluation cache first.
+Value cached_evaluate(const Position& pos, AttackInfo& ai) {
+    Value eval;
+    if (!eval_cache.probe(pos.hashkey(), eval)) {
+        eval = evaluate(pos, ai);
+        eval_cache.store(pos.hashkey(), eval);
+    }
+    return eval;
+}
+
+// Static evaluation that may stop after the material balance when it is far outside the window.
+// Lazy scores are not cached.
+Value lazy_evaluate(
+    const Position& pos, SearchInfo& search_info, AttackInfo& ai, Value alpha, Value beta) {
+    Value eval;
+    if (eval_cache.probe(pos.hashkey(), eval)) {
+        return eval;
+    }
+    bool lazy = false;
+    eval      = evaluate(pos, ai, alpha - LAZY_MARGIN, beta + LAZY_MARGIN, lazy);
+    if (lazy) {
+        search_info.lazy_evals++;
+    } else {
+        eval_cache.store(pos.hashkey(), eval);
+    }
+    return eval;
+}
+
+// Counts a TT probe of `pos`, and if the entry holds the position.
+void count_tt_probe(const Position& pos, SearchInfo& search_info) {
+    if constexpr (use_search_stats) {
+        search_info.stats.inc(SearchStats::TT_PROBES);
+        if (search_info.tt->entry_address(pos.hashkey())->key == pos.hashkey()) {
+            search_info.stats.inc(SearchStats::TT_HITS);
+        }
+    }
+}
+
+// Counts a fail high on the `moves`-th move of a node.
+void count_beta_cutoff(SearchInfo& search_info, int moves) {
+    search_info.stats.inc(SearchStats::BETA_CUTOFFS);
+    if (moves == 1) {
+        search_info.stats.inc(SearchStats::FIRST_MOVE_CUTOFFS);
+    }
+}
+
+// Exit of a node that searched its moves and stored `flag` in the TT.
+constexpr NodeExit flag_exit(TTFlag flag) {
+    return flag == TTFlag::TT_BETA  ? NodeExit::FAIL_HIGH
+         : flag == TTFlag::TT_EXACT ? NodeExit::EXACT
+                                    : NodeExit::FAIL_LOW;
+}
+
+// Quiescence search over captures, or all evasions when in check. Quiet checks are also searched
+// at its first ply (depth 0).
+Value qsearch(Position& pos, SearchInfo& search_info, Value alpha, Value beta, int depth = 0) {
     int ply = search_info.depth;
     search_info.nodes++;
+    search_info.stats.inc(SearchStats::QNODES);
     search_info.seldepth       = std::max(search_info.seldepth, ply);
     search_info.pv_length[ply] = 0;
+
+    // Returns `score`, recording the node in the trace if tracing is on.
+    Value node_alpha = alpha;
+    auto  node_exit  = [&](NodeExit exit, Value score) {
+        if (search_info.trace) {
+            search_info.trace->record(ply, depth, node_alpha, beta, score, NodeType::QSEARCH, exit);
+        }
+        return score;
+    };
     if (pos.is_draw()) {
-        return VALUE_DRAW;
+        return node_exit(NodeExit::DRAW, VALUE_DRAW);
+    }
+    // The side to move can repeat an earlier position, so it scores at least a draw.
+    if (alpha < VALUE_DRAW && pos.has_game_cycle(ply)) {
+        alpha = VALUE_DRAW;
+        if (alpha >= beta) {
+            return node_exit(NodeExit::CYCLE, alpha);
+        }
     }
     if (search_info.time_out()) {
-        return VALUE_NONE;
+        return node_exit(NodeExit::TIME_OUT, VALUE_NONE);
     }
 
     // Check for transposition.
     Move  tt_move  = MOVE_NONE;
-    Value tt_score = TT.probe(pos, ply, 0, alpha, beta, tt_move);
+    Value tt_score = search_info.tt->probe(pos, ply, 0, alpha, beta, tt_move);
     bool  tt_hit   = (tt_score != VALUE_NONE);
+    count_tt_probe(pos, search_info);
     if (ply > 0 && tt_hit) {
-        return tt_score;
+        search_info.stats.inc(SearchStats::TT_CUTOFFS);
+        return node_exit(NodeExit::TT_CUTOFF, tt_score);
     }
 
-    Value eval = (tt_hit ? tt_score : evaluate(pos));
+    AttackInfo ai(pos);
+    Value      eval = (tt_hit ? tt_score : lazy_evaluate(pos, search_info, ai, alpha, beta));
     if (ply > MAX_DEPTH - 1) {
-        return eval;
+        return node_exit(NodeExit::MAX_PLY, eval);
     }
 
-    bool in_check = pos.in_check();
-    if (!in_check) {
+    bool     in_check = ai.in_check();
+    MoveList movelist;
+    if (in_check) {
+        generate_moves<GenType::EVASIONS>(pos, ai, movelist);
+        if (movelist.empty()) {
+            return node_exit(NodeExit::MATE, mated_in(ply));
+        }
+    } else {
         if (eval >= beta) {
-            return eval;
+            return node_exit(NodeExit::STAND_PAT, eval);
         }
         alpha = std::max(alpha, eval);
-    }
 
-    // Delta pruning.
-    if (eval + DELTA_MARGIN < alpha) {
-        return alpha;
-    }
+        // Delta pruning.
+        if (eval + DELTA_MARGIN < alpha) {
+            return node_exit(NodeExit::DELTA, alpha);
+        }
 
-    MoveList captures;
-    generate_moves<GenType::CAPTURE>(pos, captures);
-    sort_moves(pos, captures, MOVE_NONE);
+        generate_moves<GenType::CAPTURE>(pos, ai, movelist);
+        if (depth == 0) {
+            generate_moves<GenType::QUIET_CHECKS>(pos, ai, movelist);
+        }
+    }
+    sort_moves(pos, movelist, MOVE_NONE);
 
     Move   best_move = MOVE_NONE;
     TTFlag flag      = TTFlag::TT_ALPHA;
-    for (Move m : captures) {
+    int    moves     = 0;
+    for (Move m : movelist) {
+        moves++;
         UndoInfo info;
         search_info.depth++;
-        if (!pos.make_move(m, info)) {
-            pos.unmake_move(info);
-            search_info.depth--;
-            continue;
+        pos.make_move(m, info);
+        if (search_info.trace) {
+            search_info.trace->set_move(ply, m);
         }
-        prefetch(TT.entry_address(pos.hashkey()));
-        Value score = -qsearch(pos, search_info, -beta, -alpha);
+        prefetch(search_info.tt->entry_address(pos.hashkey()));
+        Value score = -qsearch(pos, search_info, -beta, -alpha, depth - 1);
         pos.unmake_move(info);
         search_info.depth--;
         if (score > alpha) {
@@ -80,13 +166,14 @@ Value qsearch(Position& pos, SearchInfo& search_info, Value alpha, Value beta) {
             flag      = TTFlag::TT_EXACT;
             if (alpha >= beta) {
                 flag = TTFlag::TT_BETA;
+                count_beta_cutoff(search_info, moves);
                 break;
             }
             search_info.insert_pv(ply, m);
         }
     }
-    TT.store(pos, 0, alpha, best_move, flag);
-    return alpha;
+    search_info.tt->store(pos, 0, alpha, best_move, flag);
+    return node_exit(flag_exit(flag), alpha);
 }
 
 // Negamax search with alpha-beta pruning.
@@ -95,16 +182,34 @@ Value negamax(
     int  ply       = search_info.depth;
     bool root_node = (ply == 0);
     search_info.nodes++;
+    search_info.stats.inc(SearchStats::NODES);
     search_info.seldepth       = std::max(search_info.seldepth, ply);
     search_info.pv_length[ply] = 0;
+
+    // Returns `score`, recording the node in the trace if tracing is on.
+    Value node_alpha = alpha, node_beta = beta;
+    auto  node_exit  = [&](NodeExit exit, Value score) {
+        if (search_info.trace) {
+            NodeType type = (node_beta - node_alpha > 1 ? NodeType::PV : NodeType::NON_PV);
+            search_info.trace->record(ply, depth, node_alpha, node_beta, score, type, exit);
+        }
+        return score;
+    };
     if (!root_node && pos.is_draw()) {
-        return VALUE_DRAW;
+        return node_exit(NodeExit::DRAW, VALUE_DRAW);
+    }
+    if (!root_node && alpha < VALUE_DRAW && pos.has_game_cycle(ply)) {
+        alpha = VALUE_DRAW;
+        if (alpha >= beta) {
+            return node_exit(NodeExit::CYCLE, alpha);
+        }
     }
     if (search_info.time_out()) {
-        return VALUE_NONE;
+        return node_exit(NodeExit::TIME_OUT, VALUE_NONE);
     }
     if (ply > MAX_DEPTH - 1) {
-        return evaluate(pos);
+        AttackInfo ai(pos);
+        return node_exit(NodeExit::MAX_PLY, cached_evaluate(pos, ai));
     }
 
     // Mate distance pruning.
@@ -112,36 +217,40 @@ Value negamax(
         alpha = std::max(alpha, mated_in(ply));
         beta  = std::min(beta, mate_in(ply + 1));
         if (alpha >= beta) {
-            return alpha;
+            return node_exit(NodeExit::MATE_DISTANCE, alpha);
         }
     }
 
     bool pv_node = (beta - alpha > 1);
     // Check for transposition.
     Move  tt_move  = MOVE_NONE;
-    Value tt_score = TT.probe(pos, ply, depth, alpha, beta, tt_move);
+    Value tt_score = search_info.tt->probe(pos, ply, depth, alpha, beta, tt_move);
     bool  tt_hit   = (tt_score != VALUE_NONE);
+    count_tt_probe(pos, search_info);
     if (!root_node && tt_hit && !pv_node) {
-        return tt_score;
+        search_info.stats.inc(SearchStats::TT_CUTOFFS);
+        return node_exit(NodeExit::TT_CUTOFF, tt_score);
     }
 
     // Check extension.
-    bool in_check = pos.in_check();
+    AttackInfo ai(pos);
+    bool       in_check = ai.in_check();
     if (in_check) {
         depth++;
     }
     if (depth <= 0) {
-        return qsearch(pos, search_info, alpha, beta);
+        return node_exit(NodeExit::QSEARCH, qsearch(pos, search_info, alpha, beta));
     }
 
     Value eval = VALUE_INF;
     if (!in_check) {
         // Use evaluation stored in TT.
-        eval = (tt_hit ? tt_score : evaluate(pos));
+        eval = (tt_hit ? tt_score : cached_evaluate(pos, ai));
 
         // Reverse futility pruning.
         if (depth <= 3 && eval - (RFP_BASE + RFP_MULTIPLIER * depth * depth) >= beta) {
-            return (eval + beta) / 2;
+            search_info.stats.inc(SearchStats::RFP_PRUNES);
+            return node_exit(NodeExit::RFP, (eval + beta) / 2);
         }
     }
 
@@ -152,17 +261,22 @@ Value negamax(
     if (do_null && !in_check && has_big_piece && search_info.depth > 0 && depth >= 3) {
         UndoInfo info;
         search_info.depth++;
+        search_info.stats.inc(SearchStats::NULL_MOVES);
         pos.make_null_move(info);
+        if (search_info.trace) {
+            search_info.trace->set_move(ply, MOVE_NONE);
+        }
         Value null_score = -negamax(pos, search_info, -beta, -beta + 1, depth - 1 - 2, false);
         pos.unmake_null_move(info);
         search_info.depth--;
         if (null_score >= beta) {
-            return beta;
+            search_info.stats.inc(SearchStats::NULL_CUTOFFS);
+            return node_exit(NodeExit::NULL_MOVE, beta);
         }
     }
 
     MoveList movelist;
-    generate_moves<GenType::ALL>(pos, movelist);
+    generate_moves<GenType::LEGAL>(pos, ai, movelist);
     sort_moves(pos, movelist, tt_move);
 
     Value  best_score     = -VALUE_INF;
@@ -173,27 +287,31 @@ Value negamax(
         bool     is_quiet = pos.is_quiet(m);
         UndoInfo info;
         search_info.depth++;
-        if (!pos.make_move(m, info)) {
-            pos.unmake_move(info);
-            search_info.depth--;
-            continue;
-        }
+        pos.make_move(m, info);
         moves_searched++;
+        if (search_info.trace) {
+            search_info.trace->set_move(ply, m);
+        }
         bool gives_check = pos.in_check();
         if (!root_node) {
             // Futility pruning.
             Value futility_margin = FP_BASE + FP_MULTIPLIER * depth;
             if (!in_check && depth <= 2 && is_quiet && !gives_check
                 && eval + futility_margin < alpha) {
+                search_info.stats.inc(SearchStats::FUTILITY_PRUNES);
                 pos.unmake_move(info);
                 search_info.depth--;
                 continue;
             }
         }
-        prefetch(TT.entry_address(pos.hashkey()));
+        prefetch(search_info.tt->entry_address(pos.hashkey()));
         Value score = VALUE_NONE;
         if (moves_searched >= 5 && depth >= 3 && !in_check) {
+            search_info.stats.inc(SearchStats::LMR_SEARCHES);
             score = -negamax(pos, search_info, -alpha - 1, -alpha, depth - 2, true);
+            if (score > alpha) {
+                search_info.stats.inc(SearchStats::LMR_RESEARCHES);
+            }
         } else {
             // Do search on full-depth.
             score = VALUE_INF;
@@ -215,6 +333,7 @@ Value negamax(
                 flag  = TTFlag::TT_EXACT;
                 if (alpha >= beta) {
                     flag = TTFlag::TT_BETA;
+                    count_beta_cutoff(search_info, moves_searched);
                     break;
                 }
                 search_info.insert_pv(ply, m);
@@ -223,53 +342,92 @@ Value negamax(
     }
     if (moves_searched == 0) {
         // Checkmate or Stalemate.
-        return in_check ? mated_in(ply) : VALUE_DRAW;
+        return in_check ? node_exit(NodeExit::MATE, mated_in(ply))
+                        : node_exit(NodeExit::STALEMATE, VALUE_DRAW);
     }
-    TT.store(pos, depth, best_score, best_move, flag);
-    return alpha;
+    search_info.tt->store(pos, depth, best_score, best_move, flag);
+    return node_exit(flag_exit(flag), alpha);
 }
 
 void search(Position& pos, SearchInfo& search_info) {
-    // Update TT size.
-    TT.resize(int(options["Hash"]));
+    // Update TT size. The eval cache is resized by `setoption`, on the thread that owns it.
+    if (search_info.tt == &TT) {
+        TT.resize(int(options["Hash"]));
+    }
 
     // Search for book move.
-    Book book(options["Book"]);
-    Move best_move = book.book_move(pos);
+    Move best_move = MOVE_NONE;
+    if (search_info.use_book) {
+        Book book(options["Book"]);
+        best_move = book.book_move(pos);
+    }
     if (best_move != MOVE_NONE) {
-        std::cout << "info book move" << std::endl;
-        std::cout << "bestmove " << best_move.to_string() << std::endl;
+        timeline.instant("book move");
+        search_info.best_move = best_move;
+        if (!search_info.silent) {
+            std::cout << "info book move" << std::endl;
+            std::cout << "bestmove " << best_move.to_string() << std::endl;
+        }
         return;
     }
+    timeline.instant("time limit", {{"max_time", std::int64_t(search_info.max_time)},
+                                    {"max_depth", search_info.max_depth}});
     // Aspiration window.
     Value alpha = -VALUE_INF, beta = VALUE_INF;
     // Iterative deepening.
     for (int depth = 1; depth <= search_info.max_depth; depth++) {
-        search_info.follow_pv = true;
-        Value score           = negamax(pos, search_info, alpha, beta, depth, true);
+        if (search_info.trace) {
+            search_info.trace->set_iteration(depth);
+        }
+        search_info.follow_pv     = true;
+        std::uint64_t start_nodes = search_info.nodes;
+        TimePoint     start       = current_time();
+        Value         score       = negamax(pos, search_info, alpha, beta, depth, true);
+        std::uint64_t nodes       = search_info.nodes - start_nodes;
+        search_info.stats.add_iteration(depth, nodes);
+        timeline.complete("iteration", start,
+                          {{"depth", depth}, {"nodes", std::int64_t(nodes)}, {"score", score}});
         if (search_info.time_out()) {
+            std::int64_t elapsed = std::int64_t(time_elapsed(search_info.start_time));
+            timeline.instant("time out", {{"depth", depth}, {"elapsed", elapsed}});
             break;
         }
         if (score <= alpha || score >= beta) {
+            timeline.instant("aspiration re-search",
+                             {{"depth", depth}, {"score", score}, {"fail_high", score >= beta}});
             // Research with full window.
             alpha = -VALUE_INF;
             beta  = VALUE_INF;
             depth--;
             continue;
         }
-        best_move        = search_info.pv[0][0];
-        std::uint64_t ms = time_elapsed(search_info.start_time);
-        std::cout << "info depth " << depth << " seldepth " << search_info.seldepth;
-        std::cout << " score " << value_to_string(score);
-        std::cout << " nodes " << search_info.nodes;
-        std::cout << " nps " << (search_info.nodes * 1000) / (ms + 1);
-        std::cout << " hashfull " << TT.hashfull();
-        std::cout << " time " << ms;
-        std::cout << " pv " << search_info.pv_to_string() << std::endl;
+        best_move                   = search_info.pv[0][0];
+        search_info.best_move       = best_move;
+        search_info.best_score      = score;
+        search_info.completed_depth = depth;
+        search_info.best_pv         = search_info.pv_to_string();
+        if (!search_info.silent) {
+            std::uint64_t ms = time_elapsed(search_info.start_time);
+            std::cout << "info depth " << depth << " seldepth " << search_info.seldepth;
+            std::cout << " score " << value_to_string(score);
+            std::cout << " nodes " << search_info.nodes;
+            std::cout << " nps " << (search_info.nodes * 1000) / (ms + 1);
+            std::cout << " hashfull " << search_info.tt->hashfull();
+            std::cout << " time " << ms;
+            std::cout << " pv " << search_info.pv_to_string() << std::endl;
+        }
         alpha = std::max(score - 20, -VALUE_INF);
         beta  = std::min(score + 20, VALUE_INF);
     }
-    std::cout << "bestmove " << best_move.to_string() << std::endl;
+    if (!search_info.silent) {
+        std::cout << "bestmove " << best_move.to_string() << std::endl;
+    }
+    timeline.complete("search", search_info.start_time,
+                      {{"depth", search_info.completed_depth},
+                       {"nodes", std::int64_t(search_info.nodes)}});
+    if constexpr (use_search_stats) {
+        add_search_stats(search_info.stats);
+    }
 }
 
 } // namespace sonic
@@ -11,6 +11,8 @@
 
 #include "chess/all.h"
 #include "utils/timer.h"
+#include "search_stats.h"
+#include "search_trace.h"
 #include "tt.h"
 #include "types.h"
 
@@ -21,6 +23,15 @@ struct SearchInfo {
     std::uint64_t nodes     = 0;
     std::uint64_t max_nodes = std::numeric_limits<std::uint64_t>::max() / 2;
 
+    // Evaluations that took the lazy exit.
+    std::uint64_t lazy_evals = 0;
+
+    // Counted in builds with `stats=yes` only.
+    SearchStats stats;
+
+    // Trace of the searched nodes, if tracing is on.
+    SearchTrace* trace = nullptr;
+
     // Start time of the search.
     TimePoint     start_time;
     std::uint64_t max_time = std::numeric_limits<std::uint64_t>::max() / 2;
@@ -31,7 +42,25 @@ struct SearchInfo {
     int max_depth = MAX_DEPTH;
 
     bool stop = false;
-    bool time_out() const { return stop || (max_time < time_elapsed(start_time)); }
+    bool time_out() const {
+        // The node limit applies once the first iteration is complete, so there is a best move.
+        return stop || (completed_depth > 0 && nodes >= max_nodes)
+            || (max_time < time_elapsed(start_time));
+    }
+
+    // Result of the last completed iteration.
+    Move        best_move       = MOVE_NONE;
+    Value       best_score      = VALUE_NONE;
+    int         completed_depth = 0;
+    std::string best_pv;
+
+    // Don't print the info and bestmove lines.
+    bool silent = false;
+    // Play moves from the opening book.
+    bool use_book = true;
+
+    // Transposition table of the search. The searches of `analyze` each have their own.
+    TranspositionTable* tt = &TT;
 
     std::array<std::uint64_t, MAX_DEPTH> history_keys;
 
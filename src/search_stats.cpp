@@ -0,0 +1,82 @@
+#include "search_stats.h"
+
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace sonic {
+
+namespace {
+
+std::mutex  total_mutex;
+SearchStats total;
+
+#if defined(USE_SEARCH_STATS)
+// Percentage of `part` in `whole`.
+double percent(std::uint64_t part, std::uint64_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+#endif
+
+} // namespace
+
+#if defined(USE_SEARCH_STATS)
+void SearchStats::merge(const SearchStats& other) {
+    for (int i = 0; i < COUNTER_NB; i++) {
+        counters[i] += other.counters[i];
+    }
+    for (int depth = 0; depth <= MAX_DEPTH; depth++) {
+        iteration_nodes[depth] += other.iteration_nodes[depth];
+    }
+}
+
+std::string SearchStats::to_string() const {
+    const auto&        c = counters;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Nodes           : " << c[NODES] + c[QNODES] << " (" << c[QNODES] << " qsearch, "
+        << percent(c[QNODES], c[NODES] + c[QNODES]) << "%)\n";
+    out << "TT hits         : " << c[TT_HITS] << "/" << c[TT_PROBES] << " ("
+        << percent(c[TT_HITS], c[TT_PROBES]) << "%), " << c[TT_CUTOFFS] << " cutoffs ("
+        << percent(c[TT_CUTOFFS], c[TT_PROBES]) << "%)\n";
+    out << "Beta cutoffs    : " << c[BETA_CUTOFFS] << " (" << c[FIRST_MOVE_CUTOFFS]
+        << " on the first move, " << percent(c[FIRST_MOVE_CUTOFFS], c[BETA_CUTOFFS]) << "%)\n";
+    out << "RFP prunes      : " << c[RFP_PRUNES] << "\n";
+    out << "Null moves      : " << c[NULL_MOVES] << " (" << c[NULL_CUTOFFS] << " cutoffs, "
+        << percent(c[NULL_CUTOFFS], c[NULL_MOVES]) << "%)\n";
+    out << "Futility prunes : " << c[FUTILITY_PRUNES] << "\n";
+    out << "LMR searches    : " << c[LMR_SEARCHES] << " (" << c[LMR_RESEARCHES] << " re-searched, "
+        << percent(c[LMR_RESEARCHES], c[LMR_SEARCHES]) << "%)\n";
+    out << "Branching factor:";
+    out << std::setprecision(2);
+    for (int depth = 2; depth <= MAX_DEPTH; depth++) {
+        std::uint64_t nodes = iteration_nodes[depth], previous = iteration_nodes[depth - 1];
+        if (nodes && previous) {
+            out << " " << depth << ":" << double(nodes) / previous;
+        }
+    }
+    out << "\n";
+    return out.str();
+}
+#else
+void SearchStats::merge(const SearchStats&) {}
+
+std::string SearchStats::to_string() const { return ""; }
+#endif
+
+void add_search_stats(const SearchStats& stats) {
+    std::lock_guard<std::mutex> lock(total_mutex);
+    total.merge(stats);
+}
+
+SearchStats total_search_stats() {
+    std::lock_guard<std::mutex> lock(total_mutex);
+    return total;
+}
+
+void clear_search_stats() {
+    std::lock_guard<std::mutex> lock(total_mutex);
+    total = SearchStats();
+}
+
+} // namespace sonic
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "types.h"
+
+namespace sonic {
+
+// Search statistics are only gathered in builds with `stats=yes`. Otherwise the counting calls
+// compile to nothing.
+#if defined(USE_SEARCH_STATS)
+constexpr bool use_search_stats = true;
+#else
+constexpr bool use_search_stats = false;
+#endif
+
+// Counters of how the search prunes and cuts, kept by each search thread.
+struct SearchStats {
+    enum Counter : int {
+        NODES,              // negamax nodes
+        QNODES,             // qsearch nodes
+        TT_PROBES,          // negamax and qsearch probes
+        TT_HITS,            // probes that found the position
+        TT_CUTOFFS,         // probes whose score ended the node
+        BETA_CUTOFFS,       // nodes with a move failing high
+        FIRST_MOVE_CUTOFFS, // ... on their first move
+        RFP_PRUNES,         // reverse futility pruning
+        NULL_MOVES,         // null move searches
+        NULL_CUTOFFS,       // null move searches failing high
+        FUTILITY_PRUNES,    // quiet moves skipped by futility pruning
+        LMR_SEARCHES,       // reduced late move searches
+        LMR_RESEARCHES,     // reduced searches beating alpha, searched again at full depth
+        COUNTER_NB
+    };
+
+#if defined(USE_SEARCH_STATS)
+    std::array<std::uint64_t, COUNTER_NB> counters = {};
+    // Nodes of each iteration of iterative deepening, including its aspiration re-searches.
+    std::array<std::uint64_t, MAX_DEPTH + 1> iteration_nodes = {};
+
+    void inc(Counter counter) { counters[counter]++; }
+    void add_iteration(int depth, std::uint64_t nodes) { iteration_nodes[depth] += nodes; }
+#else
+    // Without `stats=yes` there are no counters, so a SearchInfo carries no statistics state.
+    void inc(Counter) {}
+    void add_iteration(int, std::uint64_t) {}
+#endif
+
+    void merge(const SearchStats& other);
+
+    // Returns the counters and the rates derived from them, one per line, and the effective
+    // branching factor of each iteration.
+    std::string to_string() const;
+};
+
+// Statistics of all searches since the last clear. Each search thread merges its own statistics
+// in when its search ends.
+void        add_search_stats(const SearchStats& stats);
+SearchStats total_search_stats();
+void        clear_search_stats();
+
+} // namespace sonic
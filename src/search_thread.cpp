@@ -0,0 +1,50 @@
+#include "search_thread.h"
+
+#include <utility>
+
+namespace sonic {
+
+SearchThread::SearchThread() :
+    thread(&SearchThread::idle_loop, this) {}
+
+SearchThread::~SearchThread() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+void SearchThread::run(std::function<void()> new_job) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return !busy; });
+    job  = std::move(new_job);
+    busy = true;
+    lock.unlock();
+    cv.notify_all();
+}
+
+void SearchThread::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return !busy; });
+}
+
+void SearchThread::idle_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [&] { return busy || quit; });
+        if (quit) {
+            return;
+        }
+        lock.unlock();
+        job();
+        lock.lock();
+        job  = nullptr;
+        busy = false;
+        cv.notify_all();
+    }
+}
+
+} // namespace sonic
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace sonic {
+
+// Thread that runs the searches of the UCI loop one after the other. It lives as long as the
+// loop, so its thread-local tables (material table, evaluation cache) carry over between moves
+// instead of being built again for every `go`.
+class SearchThread {
+   public:
+    SearchThread();
+    ~SearchThread();
+    SearchThread(const SearchThread&)            = delete;
+    SearchThread& operator=(const SearchThread&) = delete;
+
+    // Runs `job` on the search thread, after the previous job is done.
+    void run(std::function<void()> job);
+    // Waits until the current job, if any, is done.
+    void wait();
+
+   private:
+    void idle_loop();
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::function<void()>   job;
+    bool                    busy = false;
+    bool                    quit = false;
+    std::thread             thread;
+};
+
+} // namespace sonic
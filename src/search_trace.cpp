@@ -0,0 +1,108 @@
+#include "search_trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+namespace sonic {
+
+namespace {
+
+// Start of every trace file, followed by the records.
+constexpr char TRACE_MAGIC[8] = {'S', 'O', 'N', 'I', 'C', 'T', 'R', '1'};
+
+constexpr const char* ExitNames[int(NodeExit::EXIT_NB)] = {
+    "draw",    "cycle",     "time out",  "max ply",   "mate distance", "tt cutoff",
+    "qsearch", "rfp",       "null move", "stand pat", "delta",         "mate",
+    "stalemate", "fail high", "fail low", "exact"};
+
+constexpr const char* TypeNames[int(NodeType::TYPE_NB)] = {"pv", "non-pv", "qsearch"};
+
+// Prints the rows of a table of node counts, largest first, with their share of `total`.
+template<typename Key>
+void print_table(const std::string&                  title,
+                 const std::map<Key, std::uint64_t>& counts,
+                 std::uint64_t                       total,
+                 bool                                sort_by_count,
+                 std::string (*key_name)(const Key&)) {
+    std::vector<std::pair<Key, std::uint64_t>> rows(counts.begin(), counts.end());
+    if (sort_by_count) {
+        std::stable_sort(rows.begin(), rows.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
+    }
+    std::cout << std::endl
+              << std::left << std::setw(16) << title << std::right << std::setw(14) << "nodes"
+              << std::setw(10) << "share" << std::endl;
+    for (const auto& [key, count] : rows) {
+        std::cout << std::left << std::setw(16) << key_name(key) << std::right << std::setw(14)
+                  << count << std::setw(9) << std::fixed << std::setprecision(1)
+                  << 100.0 * count / std::max<std::uint64_t>(total, 1) << "%" << std::endl;
+    }
+}
+
+} // namespace
+
+SearchTrace::SearchTrace(const std::string& filename) :
+    out(filename, std::ios::binary) {
+    buffer.reserve(BUFFER_RECORDS);
+    out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+}
+
+SearchTrace::~SearchTrace() { flush(); }
+
+void SearchTrace::flush() {
+    out.write(reinterpret_cast<const char*>(buffer.data()),
+              std::streamsize(buffer.size() * sizeof(TraceRecord)));
+    out.flush();
+    buffer.clear();
+}
+
+void read_trace(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 2) {
+        std::cout << "Usage: readtrace <file>" << std::endl;
+        return;
+    }
+    std::ifstream in(tokens[1], std::ios::binary);
+    char          magic[sizeof(TRACE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        std::cout << "Not a search trace: " << tokens[1] << std::endl;
+        return;
+    }
+
+    std::uint64_t                          total = 0;
+    std::map<std::uint16_t, std::uint64_t> by_root_move;
+    std::map<int, std::uint64_t>           by_iteration, by_exit, by_type;
+    std::vector<TraceRecord>               records(1 << 16);
+    while (in) {
+        in.read(reinterpret_cast<char*>(records.data()),
+                std::streamsize(records.size() * sizeof(TraceRecord)));
+        std::size_t count = std::size_t(in.gcount()) / sizeof(TraceRecord);
+        for (std::size_t i = 0; i < count; i++) {
+            const TraceRecord& r = records[i];
+            by_root_move[r.root_move]++;
+            by_iteration[r.iteration]++;
+            by_exit[int(r.exit)]++;
+            by_type[int(r.type)]++;
+        }
+        total += count;
+    }
+
+    std::cout << "Nodes           : " << total << " (";
+    for (int type = 0; type < int(NodeType::TYPE_NB); type++) {
+        std::cout << (type ? ", " : "") << by_type[type] << " " << TypeNames[type];
+    }
+    std::cout << ")" << std::endl;
+    print_table<std::uint16_t>("Root move", by_root_move, total, true,
+                               [](const std::uint16_t& move) {
+                                   return move ? Move(move).to_string() : std::string("(root)");
+                               });
+    print_table<int>("Iteration", by_iteration, total, false,
+                     [](const int& iteration) { return std::to_string(iteration); });
+    print_table<int>("Exit", by_exit, total, true, [](const int& exit) {
+        return std::string(exit < int(NodeExit::EXIT_NB) ? ExitNames[exit] : "?");
+    });
+}
+
+} // namespace sonic
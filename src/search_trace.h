@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "chess/all.h"
+#include "types.h"
+
+namespace sonic {
+
+// Why a search node returned.
+enum class NodeExit : std::uint8_t {
+    DRAW,
+    CYCLE,
+    TIME_OUT,
+    MAX_PLY,
+    MATE_DISTANCE,
+    TT_CUTOFF,
+    QSEARCH, // negamax node at depth 0, continued by a qsearch node
+    RFP,
+    NULL_MOVE,
+    STAND_PAT,
+    DELTA,
+    MATE,
+    STALEMATE,
+    FAIL_HIGH,
+    FAIL_LOW,
+    EXACT,
+    EXIT_NB
+};
+
+enum class NodeType : std::uint8_t {
+    PV,
+    NON_PV,
+    QSEARCH,
+    TYPE_NB
+};
+
+// A search node as stored in a trace file. `move` led to the node and `root_move` is the root
+// move of its subtree.
+struct TraceRecord {
+    std::uint16_t move;
+    std::uint16_t root_move;
+    std::int16_t  alpha;
+    std::int16_t  beta;
+    std::int16_t  score;
+    std::uint8_t  ply;
+    std::int8_t   depth;
+    std::uint8_t  iteration;
+    NodeType      type;
+    NodeExit      exit;
+    std::uint8_t  unused;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "trace records have a fixed size");
+
+// Writes the nodes of the searches to a binary file: a header, then one record per node in the
+// order the nodes return. Records are buffered and written in large blocks to keep tracing cheap
+// enough for long searches.
+class SearchTrace {
+   public:
+    explicit SearchTrace(const std::string& filename);
+    ~SearchTrace();
+
+    bool is_open() const { return bool(out); }
+
+    void set_iteration(int depth) { iteration = std::uint8_t(depth); }
+    // Sets the move played at `ply`, which leads to the nodes at `ply + 1`.
+    void set_move(int ply, Move move) { path[ply + 1] = move; }
+
+    void record(int      ply,
+                int      depth,
+                Value    alpha,
+                Value    beta,
+                Value    score,
+                NodeType type,
+                NodeExit exit) {
+        Move root_move = (ply > 0 ? path[1] : MOVE_NONE);
+        buffer.push_back({path[ply].to_int(), root_move.to_int(), std::int16_t(alpha),
+                          std::int16_t(beta), std::int16_t(score), std::uint8_t(ply),
+                          std::int8_t(depth), iteration, type, exit, 0});
+        if (buffer.size() == BUFFER_RECORDS) {
+            flush();
+        }
+    }
+
+    void flush();
+
+   private:
+    static constexpr std::size_t BUFFER_RECORDS = 1 << 16;
+
+    std::ofstream                   out;
+    std::vector<TraceRecord>        buffer;
+    std::array<Move, MAX_DEPTH + 2> path      = {};
+    std::uint8_t                    iteration = 0;
+};
+
+// Reads a trace file and prints its nodes by root move, by iteration and by exit reason.
+// Usage: readtrace <file>
+void read_trace(const std::vector<std::string>& tokens);
+
+} // namespace sonic
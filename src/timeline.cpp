@@ -0,0 +1,127 @@
+#include "timeline.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sonic {
+
+Timeline timeline;
+
+namespace {
+
+struct ThreadBuffer {
+    int                        tid;
+    bool                       in_use = false;
+    std::vector<TimelineEvent> events;
+};
+
+// Guards the list of buffers, not their events.
+std::mutex                                 buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+// Buffer of the current thread, taken on its first event and given back when the thread exits.
+struct BufferLease {
+    ThreadBuffer* buffer = nullptr;
+
+    ~BufferLease() {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffer->in_use = false;
+        }
+    }
+
+    ThreadBuffer& get() {
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            for (auto& b : buffers) {
+                if (!b->in_use) {
+                    buffer = b.get();
+                    break;
+                }
+            }
+            if (!buffer) {
+                buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer      = buffers.back().get();
+                buffer->tid = int(buffers.size()) - 1;
+            }
+            buffer->in_use = true;
+        }
+        return *buffer;
+    }
+};
+
+thread_local BufferLease lease;
+
+std::int64_t microseconds(TimePoint from, TimePoint to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+} // namespace
+
+Timeline::Timeline() :
+    origin(current_time()) {}
+
+void Timeline::complete(const char*                        name,
+                        TimePoint                          start,
+                        std::initializer_list<TimelineArg> args) {
+    if (enabled()) {
+        record(name, 'X', start, current_time(), args);
+    }
+}
+
+void Timeline::instant(const char* name, std::initializer_list<TimelineArg> args) {
+    if (enabled()) {
+        TimePoint now = current_time();
+        record(name, 'i', now, now, args);
+    }
+}
+
+void Timeline::record(const char*                        name,
+                      char                               phase,
+                      TimePoint                          start,
+                      TimePoint                          end,
+                      std::initializer_list<TimelineArg> args) {
+    TimelineEvent event{name, phase, microseconds(origin, start), microseconds(start, end), {}, 0};
+    for (const TimelineArg& arg : args) {
+        if (event.arg_count < int(event.args.size())) {
+            event.args[event.arg_count++] = arg;
+        }
+    }
+    lease.get().events.push_back(event);
+}
+
+bool Timeline::write(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+            << "\"tid\": " << buffer->tid << ", \"args\": {\"name\": \"thread " << buffer->tid
+            << "\"}}";
+        first = false;
+        for (const TimelineEvent& e : buffer->events) {
+            out << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"" << e.phase
+                << "\", \"ts\": " << e.start_us;
+            if (e.phase == 'X') {
+                out << ", \"dur\": " << e.duration_us;
+            } else {
+                out << ", \"s\": \"t\"";
+            }
+            out << ", \"pid\": 1, \"tid\": " << buffer->tid << ", \"args\": {";
+            for (int i = 0; i < e.arg_count; i++) {
+                out << (i ? ", " : "") << "\"" << e.args[i].name << "\": " << e.args[i].value;
+            }
+            out << "}}";
+        }
+    }
+    out << "\n]}" << std::endl;
+    return bool(out);
+}
+
+} // namespace sonic
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+#include "utils/timer.h"
+
+namespace sonic {
+
+struct TimelineArg {
+    const char*  name;
+    std::int64_t value;
+};
+
+// Event of the timeline. Names are string literals, so events are cheap to record.
+struct TimelineEvent {
+    const char*                name;
+    char                       phase; // 'X' for an event with a duration, 'i' for an instant
+    std::int64_t               start_us;
+    std::int64_t               duration_us;
+    std::array<TimelineArg, 3> args;
+    int                        arg_count;
+};
+
+// Records search events (iterations, aspiration re-searches, time decisions, TT clears) of all
+// threads while enabled, and writes them as a Chrome trace_event JSON file, which trace viewers
+// such as chrome://tracing or Perfetto show as a timeline. Each thread appends to its own buffer
+// without locking; buffers of finished threads are reused by new ones.
+class Timeline {
+   public:
+    Timeline();
+
+    void enable(bool on) { enabled_flag.store(on, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_flag.load(std::memory_order_relaxed); }
+
+    // Records an event of the current thread from `start` until now.
+    void complete(const char* name, TimePoint start, std::initializer_list<TimelineArg> args = {});
+    // Records an instant event of the current thread.
+    void instant(const char* name, std::initializer_list<TimelineArg> args = {});
+
+    // Writes the events of all threads, and returns if the file could be written. No thread may
+    // record events meanwhile.
+    bool write(const std::string& filename) const;
+
+   private:
+    void record(const char*                        name,
+                char                               phase,
+                TimePoint                          start,
+                TimePoint                          end,
+                std::initializer_list<TimelineArg> args);
+
+    std::atomic<bool> enabled_flag{false};
+    TimePoint         origin;
+};
+
+extern Timeline timeline;
+
+} // namespace sonic
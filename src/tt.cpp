@@ -3,6 +3,7 @@
 #include <cstdint>
 
 #include "chess/all.h"
+#include "timeline.h"
 #include "types.h"
 
 namespace sonic {
@@ -17,15 +18,19 @@ void TranspositionTable::resize(std::size_t mbSize) {
         new_size *= 2;
     }
     if (new_size != size) {
-        size = new_size;
+        TimePoint start = current_time();
+        size            = new_size;
         entries.resize(size);
         clear();
+        timeline.complete("tt resize", start, {{"mb", std::int64_t(mbSize)}});
     }
 }
 
 void TranspositionTable::clear() {
+    TimePoint start = current_time();
     std::fill(entries.begin(), entries.end(), TTEntry());
     entries_count = 0;
+    timeline.complete("tt clear", start, {{"entries", std::int64_t(size)}});
 }
 
 Value TranspositionTable::probe(
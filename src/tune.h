@@ -28,6 +28,7 @@ struct TunableParam {
 
 #define TUNE_PARAM(name, value, min, max) TunableParam name(#name, value, min, max)
 
+TUNE_PARAM(LAZY_MARGIN, 400, 0, 3000);
 TUNE_PARAM(DELTA_MARGIN, 850, 100, 3000);
 TUNE_PARAM(RFP_BASE, 250, 50, 900);
 TUNE_PARAM(RFP_MULTIPLIER, 70, 20, 500);
@@ -0,0 +1,456 @@
+#include "tuner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "chess/all.h"
+#include "utils/strings.h"
+#include "utils/timer.h"
+#include "eval_params.h"
+#include "evaluate.h"
+#include "types.h"
+
+namespace sonic {
+
+namespace {
+
+// Layout of the parameter vector.
+constexpr int PSQT_OFFSET     = 0;
+constexpr int MOBILITY_OFFSET = PSQT_OFFSET + PieceType::PIECE_NB * Square::SQ_NB;
+constexpr int PASSED_OFFSET   = MOBILITY_OFFSET + PieceType::PIECE_NB;
+constexpr int NUM_PARAMS      = PASSED_OFFSET + 8;
+
+constexpr int    BATCH_SIZE    = 64;
+constexpr double LEARNING_RATE = 1.0;
+
+// Middle game and end game value of a parameter.
+struct Pair {
+    double mg = 0;
+    double eg = 0;
+};
+
+// Non-zero coefficient of a parameter in a position. Mobility coefficients are summed over all
+// pieces of a type, which with promoted pieces can exceed the range of a byte.
+#pragma pack(push, 1)
+struct Feature {
+    std::uint16_t index;
+    std::int16_t  coeff;
+};
+#pragma pack(pop)
+
+// Labeled position reduced to the inputs of the linear evaluation model.
+struct TuneEntry {
+    std::uint64_t offset; // First feature of the position.
+    float         result; // 1 for a white win, 0.5 for a draw and 0 for a black win.
+    std::int16_t  base_mg;
+    std::int16_t  base_eg;
+    std::uint8_t  phase;
+    std::uint8_t  scale;
+    std::uint8_t  count;
+};
+
+struct Dataset {
+    std::vector<TuneEntry> entries;
+    std::vector<Feature>   features;
+};
+
+// Header of the binary feature cache, stored next to the EPD file.
+struct CacheHeader {
+    char          magic[8];
+    std::uint64_t num_params;
+    std::uint64_t epd_size;
+    std::uint64_t num_entries;
+    std::uint64_t num_features;
+};
+
+constexpr char CACHE_MAGIC[8] = {'S', 'O', 'N', 'I', 'C', 'T', 'N', '3'};
+
+std::uint64_t file_size(const std::string& file) {
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    return in ? std::uint64_t(in.tellg()) : 0;
+}
+
+// Parses an EPD line with a game result such as `c9 "1-0";` or `[0.5]`.
+bool parse_line(const std::string& line, std::string& fen, float& result) {
+    if (line.find("1/2-1/2") != std::string::npos || line.find("[0.5]") != std::string::npos) {
+        result = 0.5f;
+    } else if (line.find("1-0") != std::string::npos || line.find("[1.0]") != std::string::npos) {
+        result = 1.0f;
+    } else if (line.find("0-1") != std::string::npos || line.find("[0.0]") != std::string::npos) {
+        result = 0.0f;
+    } else {
+        return false;
+    }
+    std::vector<std::string> tokens = split_string(line, ' ');
+    if (tokens.size() < 4 || std::count(tokens[0].begin(), tokens[0].end(), '/') != 7) {
+        return false;
+    }
+    auto is_number = [](const std::string& s) {
+        return !s.empty() && std::all_of(s.begin(), s.end(), ::isdigit);
+    };
+    fen = tokens[0] + " " + tokens[1] + " " + tokens[2] + " " + tokens[3];
+    if (tokens.size() >= 6 && is_number(tokens[4]) && is_number(tokens[5])) {
+        fen += " " + tokens[4] + " " + tokens[5];
+    } else {
+        fen += " 0 1";
+    }
+    return true;
+}
+
+// Appends the features of `pos`. Positions scored by endgame functions are skipped.
+bool extract(const Position& pos, float result, Dataset& data) {
+    EvalTrace trace;
+    evaluate(pos, trace);
+    if (trace.endgame) {
+        return false;
+    }
+    TuneEntry entry;
+    entry.offset  = data.features.size();
+    entry.result  = result;
+    entry.base_mg = std::int16_t(trace.base.first);
+    entry.base_eg = std::int16_t(trace.base.second);
+    entry.phase   = std::uint8_t(trace.phase);
+    entry.scale   = std::uint8_t(trace.scale);
+
+    auto add = [&](int index, int coeff) {
+        if (coeff != 0) {
+            data.features.push_back({std::uint16_t(index), std::int16_t(coeff)});
+        }
+    };
+    for (int pt = 0; pt < PieceType::PIECE_NB; pt++) {
+        for (int sq = 0; sq < Square::SQ_NB; sq++) {
+            add(PSQT_OFFSET + pt * Square::SQ_NB + sq, trace.psqt[pt][sq]);
+        }
+        add(MOBILITY_OFFSET + pt, trace.mobility[pt]);
+    }
+    for (int rank = 0; rank < 8; rank++) {
+        add(PASSED_OFFSET + rank, trace.passed_pawn[rank]);
+    }
+    entry.count = std::uint8_t(data.features.size() - entry.offset);
+    data.entries.push_back(entry);
+    return true;
+}
+
+// Extracts the features of an EPD file, in parallel over chunks of lines.
+Dataset extract_file(const std::string& file, int threads) {
+    constexpr std::size_t CHUNK_SIZE = 1 << 20;
+
+    Dataset       data;
+    std::ifstream in(file);
+    std::uint64_t lines = 0;
+    TimePoint     start = current_time();
+    while (in) {
+        std::vector<std::string> chunk;
+        std::string              line;
+        while (chunk.size() < CHUNK_SIZE && std::getline(in, line)) {
+            chunk.push_back(line);
+        }
+        lines += chunk.size();
+
+        std::vector<Dataset>     parts(threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                Position    pos;
+                std::string fen;
+                float       result;
+                for (std::size_t i = t; i < chunk.size(); i += threads) {
+                    if (parse_line(chunk[i], fen, result)) {
+                        pos.set(fen);
+                        extract(pos, result, parts[t]);
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        for (Dataset& part : parts) {
+            std::uint64_t base = data.features.size();
+            for (TuneEntry entry : part.entries) {
+                entry.offset += base;
+                data.entries.push_back(entry);
+            }
+            data.features.insert(data.features.end(), part.features.begin(), part.features.end());
+        }
+        std::cout << "info string read " << lines << " lines, " << data.entries.size()
+                  << " positions (" << time_elapsed(start) / 1000 << "s)" << std::endl;
+    }
+    return data;
+}
+
+bool load_cache(const std::string& file, std::uint64_t epd_size, Dataset& data) {
+    std::ifstream in(file, std::ios::binary);
+    CacheHeader   header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || header.num_params != NUM_PARAMS || header.epd_size != epd_size) {
+        return false;
+    }
+    data.entries.resize(header.num_entries);
+    data.features.resize(header.num_features);
+    in.read(reinterpret_cast<char*>(data.entries.data()),
+            std::streamsize(data.entries.size() * sizeof(TuneEntry)));
+    in.read(reinterpret_cast<char*>(data.features.data()),
+            std::streamsize(data.features.size() * sizeof(Feature)));
+    return bool(in);
+}
+
+void save_cache(const std::string& file, std::uint64_t epd_size, const Dataset& data) {
+    std::ofstream out(file, std::ios::binary);
+    CacheHeader   header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.num_params   = NUM_PARAMS;
+    header.epd_size     = epd_size;
+    header.num_entries  = data.entries.size();
+    header.num_features = data.features.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data.entries.data()),
+              std::streamsize(data.entries.size() * sizeof(TuneEntry)));
+    out.write(reinterpret_cast<const char*>(data.features.data()),
+              std::streamsize(data.features.size() * sizeof(Feature)));
+}
+
+std::vector<Pair> initial_params() {
+    std::vector<Pair> params(NUM_PARAMS);
+    for (int pt = 0; pt < PieceType::PIECE_NB; pt++) {
+        for (int sq = 0; sq < Square::SQ_NB; sq++) {
+            int index     = PSQT_OFFSET + pt * Square::SQ_NB + sq;
+            params[index] = {double(PieceSquareTable[pt][sq].first),
+                             double(PieceSquareTable[pt][sq].second)};
+        }
+        params[MOBILITY_OFFSET + pt] = {double(MobilityMult[pt].first),
+                                        double(MobilityMult[pt].second)};
+    }
+    for (int rank = 0; rank < 8; rank++) {
+        params[PASSED_OFFSET + rank] = {double(PassedPawnBonus[rank].first),
+                                        double(PassedPawnBonus[rank].second)};
+    }
+    return params;
+}
+
+// Sum of squared errors of entries [begin, end) between the results and the sigmoid of the
+// evaluation. If `grad` is given, the gradient of the sum is added to it.
+//
+// Entries are processed in batches: the sparse dot products are gathered first, then the error
+// terms of the whole batch are computed by a branch-free loop over contiguous arrays which the
+// compiler vectorizes.
+double batch_error(const Dataset&    data,
+                   const Pair*       params,
+                   double            k,
+                   std::size_t       begin,
+                   std::size_t       end,
+                   std::vector<Pair>* grad) {
+    alignas(64) double mg[BATCH_SIZE], eg[BATCH_SIZE], mg_weight[BATCH_SIZE],
+        eg_weight[BATCH_SIZE], result[BATCH_SIZE], mg_grad[BATCH_SIZE], eg_grad[BATCH_SIZE];
+    double error = 0;
+    for (std::size_t first = begin; first < end; first += BATCH_SIZE) {
+        int n = int(std::min<std::size_t>(BATCH_SIZE, end - first));
+        for (int j = 0; j < n; j++) {
+            const TuneEntry& entry    = data.entries[first + j];
+            const Feature*   features = &data.features[entry.offset];
+            double           mg_sum   = entry.base_mg, eg_sum = entry.base_eg;
+            for (int f = 0; f < entry.count; f++) {
+                mg_sum += features[f].coeff * params[features[f].index].mg;
+                eg_sum += features[f].coeff * params[features[f].index].eg;
+            }
+            mg[j]        = mg_sum;
+            eg[j]        = eg_sum;
+            mg_weight[j] = entry.phase / 195.0;
+            eg_weight[j] = (78 - entry.phase) * entry.scale / (64.0 * 195.0);
+            result[j]    = entry.result;
+        }
+        for (int j = 0; j < n; j++) {
+            double eval    = mg[j] * mg_weight[j] + eg[j] * eg_weight[j];
+            double sigmoid = 1 / (1 + std::exp(-k * eval));
+            double diff    = result[j] - sigmoid;
+            double d_eval  = -2 * diff * sigmoid * (1 - sigmoid) * k;
+            error += diff * diff;
+            mg_grad[j] = d_eval * mg_weight[j];
+            eg_grad[j] = d_eval * eg_weight[j];
+        }
+        if (grad != nullptr) {
+            for (int j = 0; j < n; j++) {
+                const TuneEntry& entry    = data.entries[first + j];
+                const Feature*   features = &data.features[entry.offset];
+                for (int f = 0; f < entry.count; f++) {
+                    Pair& g = (*grad)[features[f].index];
+                    g.mg += features[f].coeff * mg_grad[j];
+                    g.eg += features[f].coeff * eg_grad[j];
+                }
+            }
+        }
+    }
+    return error;
+}
+
+// Mean squared error over the dataset, split across threads. If `grad` is given, it receives the
+// gradient of the mean.
+double mean_error(const Dataset&           data,
+                  const std::vector<Pair>& params,
+                  double                   k,
+                  int                      threads,
+                  std::vector<Pair>*       grad) {
+    std::vector<double>            errors(threads, 0);
+    std::vector<std::vector<Pair>> grads(threads, std::vector<Pair>(grad ? NUM_PARAMS : 0));
+    std::vector<std::thread>       workers;
+    std::size_t                    size = data.entries.size();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            std::size_t begin = size * t / threads, end = size * (t + 1) / threads;
+            errors[t]         = batch_error(data, params.data(), k, begin, end,
+                                            grad ? &grads[t] : nullptr);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double error = 0;
+    for (int t = 0; t < threads; t++) {
+        error += errors[t];
+        if (grad != nullptr) {
+            for (int i = 0; i < NUM_PARAMS; i++) {
+                (*grad)[i].mg += grads[t][i].mg / size;
+                (*grad)[i].eg += grads[t][i].eg / size;
+            }
+        }
+    }
+    return error / size;
+}
+
+// Finds the sigmoid scaling constant that best fits the current evaluation.
+double fit_k(const Dataset& data, const std::vector<Pair>& params, int threads) {
+    double lo = 0.001, hi = 0.05;
+    for (int iter = 0; iter < 40; iter++) {
+        double m1 = lo + (hi - lo) / 3, m2 = hi - (hi - lo) / 3;
+        if (mean_error(data, params, m1, threads, nullptr)
+            < mean_error(data, params, m2, threads, nullptr)) {
+            hi = m2;
+        } else {
+            lo = m1;
+        }
+    }
+    return (lo + hi) / 2;
+}
+
+// Writes the parameters in the format of eval_params.h.
+void write_params(const std::string& file, const std::vector<Pair>& params) {
+    static const char* piece_names[PieceType::PIECE_NB] = {"Pawn", "Knight", "Bishop",
+                                                           "Rook", "Queen",  "King"};
+    auto pair_to_string = [](const Pair& p) {
+        return "{" + std::to_string(std::lround(p.mg)) + ", " + std::to_string(std::lround(p.eg))
+             + "},";
+    };
+    std::ofstream out(file);
+    out << "#pragma once\n\n#include <utility>\n\n"
+        << "#include \"chess/all.h\"\n#include \"types.h\"\n\n"
+        << "namespace sonic {\n\n"
+        << "// Evaluation parameters, from white's point of view. This file is generated by "
+           "`tune-eval`.\n\n"
+        << "// clang-format off\n"
+        << "constexpr std::pair<Value, Value> PieceSquareTable[PieceType::PIECE_NB][Square::SQ_NB] "
+           "= {\n";
+    for (int pt = 0; pt < PieceType::PIECE_NB; pt++) {
+        out << "    { // " << piece_names[pt] << "\n";
+        for (int row = 0; row < 8; row++) {
+            out << "       ";
+            for (int col = 0; col < 8; col++) {
+                int index = PSQT_OFFSET + pt * Square::SQ_NB + row * 8 + col;
+                out << " " << pair_to_string(params[index]);
+            }
+            out << "\n";
+        }
+        out << "    },\n";
+    }
+    out << "};\n\nconstexpr std::pair<Value, Value> MobilityMult[PieceType::PIECE_NB] = {\n   ";
+    for (int pt = 0; pt < PieceType::PIECE_NB; pt++) {
+        out << " " << pair_to_string(params[MOBILITY_OFFSET + pt]);
+    }
+    out << "\n};\n\nconstexpr std::pair<Value, Value> PassedPawnBonus[8] = {\n   ";
+    for (int rank = 0; rank < 8; rank++) {
+        out << " " << pair_to_string(params[PASSED_OFFSET + rank]);
+    }
+    out << "\n};\n// clang-format on\n\n} // namespace sonic\n";
+}
+
+} // namespace
+
+void tune_eval(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 2) {
+        std::cout << "Usage: tune-eval <file.epd> [epochs N] [threads T] [out <file>]" << std::endl;
+        return;
+    }
+    std::string epd_file = tokens[1];
+    std::string out_file = "eval_params.h";
+    int         epochs   = 1000;
+    int         threads  = std::max(1, int(std::thread::hardware_concurrency()));
+    for (std::size_t i = 2; i + 1 < tokens.size(); i += 2) {
+        if (tokens[i] == "epochs") {
+            epochs = std::stoi(tokens[i + 1]);
+        } else if (tokens[i] == "threads") {
+            threads = std::max(1, std::stoi(tokens[i + 1]));
+        } else if (tokens[i] == "out") {
+            out_file = tokens[i + 1];
+        }
+    }
+    std::uint64_t epd_size = file_size(epd_file);
+    if (epd_size == 0) {
+        std::cout << "info string cannot read " << epd_file << std::endl;
+        return;
+    }
+
+    // Feature extraction is cached in a binary file, which is reused while the EPD file keeps its
+    // size and the parameter layout is unchanged.
+    Dataset     data;
+    std::string cache_file = epd_file + ".bin";
+    if (load_cache(cache_file, epd_size, data)) {
+        std::cout << "info string loaded " << data.entries.size() << " positions from "
+                  << cache_file << std::endl;
+    } else {
+        data = extract_file(epd_file, threads);
+        save_cache(cache_file, epd_size, data);
+    }
+    if (data.entries.empty()) {
+        std::cout << "info string no labeled positions in " << epd_file << std::endl;
+        return;
+    }
+
+    std::vector<Pair> params = initial_params();
+    double            k      = fit_k(data, params, threads);
+    std::cout << "info string K " << k << " error "
+              << mean_error(data, params, k, threads, nullptr) << std::endl;
+
+    // Adam optimizer on the full-batch gradient.
+    constexpr double  beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<Pair> momentum(NUM_PARAMS), velocity(NUM_PARAMS);
+    TimePoint         start = current_time();
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        std::vector<Pair> grad(NUM_PARAMS);
+        double            error = mean_error(data, params, k, threads, &grad);
+        for (int i = 0; i < NUM_PARAMS; i++) {
+            momentum[i].mg = beta1 * momentum[i].mg + (1 - beta1) * grad[i].mg;
+            momentum[i].eg = beta1 * momentum[i].eg + (1 - beta1) * grad[i].eg;
+            velocity[i].mg = beta2 * velocity[i].mg + (1 - beta2) * grad[i].mg * grad[i].mg;
+            velocity[i].eg = beta2 * velocity[i].eg + (1 - beta2) * grad[i].eg * grad[i].eg;
+            params[i].mg -= LEARNING_RATE * momentum[i].mg / (std::sqrt(velocity[i].mg) + epsilon);
+            params[i].eg -= LEARNING_RATE * momentum[i].eg / (std::sqrt(velocity[i].eg) + epsilon);
+        }
+        if (epoch % 10 == 0 || epoch == epochs) {
+            std::cout << "info string epoch " << epoch << " error " << error << " time "
+                      << time_elapsed(start) << std::endl;
+        }
+        if (epoch % 100 == 0) {
+            write_params(out_file, params);
+        }
+    }
+    write_params(out_file, params);
+    std::cout << "info string parameters written to " << out_file << std::endl;
+}
+
+} // namespace sonic
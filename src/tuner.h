@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sonic {
+
+// Texel tuning of the evaluation parameters on an EPD file of positions labeled with game results.
+// Usage: tune-eval <file.epd> [epochs N] [threads T] [out <file>]
+void tune_eval(const std::vector<std::string>& tokens);
+
+} // namespace sonic
@@ -17,6 +17,9 @@ constexpr Value VALUE_NONE = 32002;
 constexpr Value VALUE_INF  = 32001;
 constexpr Value VALUE_MATE = 32000;
 
+// Evaluation of endgames which are known to be won, well below any mate score.
+constexpr Value VALUE_KNOWN_WIN = 10000;
+
 constexpr bool  is_mate_value(Value score) { return VALUE_MATE - std::abs(score) <= MAX_DEPTH; }
 constexpr Value mate_in(int ply) { return VALUE_MATE - ply; }
 constexpr Value mated_in(int ply) { return -VALUE_MATE + ply; }
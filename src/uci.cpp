@@ -5,15 +5,22 @@
 #include <iostream>
 #include <istream>
 #include <limits>
+#include <memory>
 #include <mutex> // Added for thread safety
 #include <string>
-#include <thread>
 #include <vector>
 
+#include "analyze.h"
 #include "bench/benchmark.h"
+#include "bench/microbench.h"
 #include "bench/perft.h"
 #include "chess/all.h"
+#include "evalcache.h"
 #include "search.h"
+#include "search_stats.h"
+#include "search_thread.h"
+#include "timeline.h"
+#include "tuner.h"
 #include "ucioption.h"
 #include "utils/strings.h"
 #include "utils/timer.h"
@@ -27,7 +34,9 @@ OptionsMap init_options_map() {
     OptionsMap options;
     options.add_option("Book", "string", "<none>");
     options.add_option("Hash", "spin", 16, 1, 1024);
+    options.add_option("EvalCache", "spin", 1, 1, 256);
     options.add_option("Threads", "spin", 1, 1, 1); // Multi-threading currently unsupported.
+    options.add_option("Timeline", "string", "<none>");
     options.add_option("ClearHash", "button", [&]() -> void {
         std::lock_guard<std::mutex> lock(mtx); // Thread safety
         TT.clear();
@@ -37,13 +46,35 @@ OptionsMap init_options_map() {
 
 OptionsMap options = init_options_map();
 
+namespace {
+
+void write_timeline(const std::string& filename) {
+    if (!timeline.enabled()) {
+        std::cout << "Timeline is off, set the Timeline option to a file name" << std::endl;
+    } else if (!timeline.write(filename)) {
+        std::cout << "Cannot write " << filename << std::endl;
+    }
+}
+
+} // namespace
+
 void uci_loop() {
     std::cout << "Sonic Chess Engine " << version_to_string() << " by Ting-Hsuan Huang"
               << std::endl;
     Position    pos;
     SearchInfo  search_info;
     std::string cmd;
-    std::thread th;
+    // Runs the searches, so that the tables of the search thread last across moves.
+    SearchThread search_thread;
+    // The eval cache belongs to the search thread, so it is resized there, and only when the
+    // option changes rather than on the clock of every search.
+    auto resize_eval_cache = [&]() {
+        int mb = int(options["EvalCache"]);
+        search_thread.run([mb]() { eval_cache.resize(mb); });
+    };
+    resize_eval_cache();
+    // Trace file of the searches, if tracing is on.
+    std::unique_ptr<SearchTrace> trace;
 
     // Changed while loop with empty command check for better input handling
     while (std::getline(std::cin, cmd)) {
@@ -65,10 +96,18 @@ void uci_loop() {
                 if (tokens[2] == "Hash") {
                     TT.resize(int(options["Hash"]));
                 }
+                if (tokens[2] == "EvalCache") {
+                    resize_eval_cache();
+                }
+                if (tokens[2] == "Timeline") {
+                    timeline.enable(tokens[4] != "<none>");
+                }
             }
         } else if (tokens[0] == "quit") {
-            if (th.joinable()) {
-                th.join();
+            search_thread.wait();
+            trace.reset();
+            if (timeline.enabled()) {
+                write_timeline(options["Timeline"]);
             }
             std::exit(0);
         } else if (tokens[0] == "uci") {
@@ -79,36 +118,71 @@ void uci_loop() {
         } else if (tokens[0] == "isready") {
             std::cout << "readyok" << std::endl;
         } else if (tokens[0] == "ucinewgame") {
-            if (th.joinable()) {
-                th.join();
-            }
+            search_thread.wait();
             pos.set(INITIAL_FEN);
             TT.clear();
         } else if (tokens[0] == "bench") {
-            run_bench();
+            run_bench(tokens);
+        } else if (tokens[0] == "microbench") {
+            run_microbench(tokens);
+        } else if (tokens[0] == "trace") {
+            search_thread.wait();
+            trace.reset();
+            if (tokens.size() > 1 && tokens[1] != "off") {
+                trace.reset(new SearchTrace(tokens[1]));
+                if (!trace->is_open()) {
+                    std::cout << "Cannot open " << tokens[1] << std::endl;
+                    trace.reset();
+                }
+            }
+        } else if (tokens[0] == "dumptrace") {
+            search_thread.wait();
+            write_timeline(tokens.size() > 1 ? tokens[1] : std::string(options["Timeline"]));
+        } else if (tokens[0] == "readtrace") {
+            read_trace(tokens);
+        } else if (tokens[0] == "stats") {
+            if (!use_search_stats) {
+                std::cout << "Search statistics are not gathered, build with stats=yes"
+                          << std::endl;
+            } else if (tokens.size() > 1 && tokens[1] == "clear") {
+                clear_search_stats();
+            } else {
+                std::cout << total_search_stats().to_string() << std::flush;
+            }
         } else if (tokens[0] == "perft") {
-            bench_perft();
+            bool with_counters = take_flag(tokens, "counters");
+            int  threads       = (tokens.size() > 2 ? std::max(1, std::stoi(tokens[2])) : 1);
+            int  hash_mb       = (tokens.size() > 3 ? std::max(0, std::stoi(tokens[3])) : 0);
+            if (tokens.size() == 1) {
+                bench_perft(false, 1, 0, with_counters);
+            } else if (tokens[1] == "deep") {
+                bench_perft(true, threads, hash_mb, with_counters);
+            } else {
+                perft_divide(pos, std::max(1, std::stoi(tokens[1])), threads, hash_mb,
+                             with_counters);
+            }
         } else if (tokens[0] == "position") {
             parse_position(pos, search_info, tokens);
         } else if (tokens[0] == "go") {
-            if (th.joinable()) {
-                th.join();
-            }
+            search_thread.wait();
             parse_go(pos, search_info, tokens);
-            th = std::thread(search, std::ref(pos), std::ref(search_info));
+            search_info.trace = trace.get();
+            search_thread.run([&]() { search(pos, search_info); });
         } else if (tokens[0] == "stop") {
             search_info.stop = true;
-            if (th.joinable()) {
-                th.join();
-            }
+            search_thread.wait();
         } else if (tokens[0] == "d") {
             std::cout << pos.to_string() << std::endl;
         } else if (tokens[0] == "tune") {
             options.print_tune_params();
+        } else if (tokens[0] == "tune-eval") {
+            tune_eval(tokens);
+        } else if (tokens[0] == "analyze") {
+            analyze(tokens);
         } else {
             std::cout << "Unknown Command: " << cmd << std::endl;
             std::cout
-                << "Available commands: setoption, quit, uci, isready, ucinewgame, bench, perft, position, go, stop, d, tune."
+                << "Available commands: setoption, quit, uci, isready, ucinewgame, bench, microbench, perft, stats, trace, readtrace, dumptrace, position, go, stop, d, tune, tune-eval, analyze."
                 << std::endl;
         }
     }
@@ -161,9 +235,12 @@ void parse_position(Position&                       pos,
                 break;
             }
         }
-        Move     move(from, to, promotion);
+        Move move = find_legal_move(pos, Move(from, to, promotion));
+        if (move == MOVE_NONE) {
+            break;
+        }
         UndoInfo info;
-        assert(pos.make_move(move, info));
+        pos.make_move(move, info);
     }
 }
 
@@ -200,6 +277,7 @@ void parse_go(Position& pos, SearchInfo& search_info, const std::vector<std::str
         time = std::numeric_limits<int>::max() / 2;
     }
     search_info.nodes      = 0;
+    search_info.lazy_evals = 0;
     search_info.start_time = current_time();
     search_info.max_time   = time / 15 + increment / 2;
     search_info.stop       = false;
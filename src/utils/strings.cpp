@@ -1,5 +1,6 @@
 #include "strings.h"
 
+#include <algorithm>
 #include <istream>
 #include <vector>
 #include <sstream>
@@ -17,4 +18,11 @@ std::vector<std::string> split_string(const std::string& s, char delim) {
     return tokens;
 }
 
+bool take_flag(std::vector<std::string>& tokens, const std::string& token) {
+    auto end   = std::remove(tokens.begin(), tokens.end(), token);
+    bool found = (end != tokens.end());
+    tokens.erase(end, tokens.end());
+    return found;
+}
+
 } // namespace sonic
\ No newline at end of file
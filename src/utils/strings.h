@@ -7,4 +7,7 @@ namespace sonic {
 
 std::vector<std::string> split_string(const std::string& s, char delim);
 
+// Removes every occurrence of the flag `token` from `tokens`, and returns if there was one.
+bool take_flag(std::vector<std::string>& tokens, const std::string& token);
+
 } // namespace sonic